@@ -8,9 +8,24 @@ constexpr float SAMPLE_RATE = 44100.0f;
 constexpr int AUDIO_BLOCK_SIZE = 64;
 
 // Harmonic cascade settings
-constexpr int MAX_HARMONICS = 8;
+constexpr int MAX_HARMONICS = 32;
 constexpr float MIN_FREQ = 27.5f;   // A0
 constexpr float MAX_FREQ = 880.0f;  // A5
+constexpr float CASCADE_DECAY_TIME = 1.0f;  // 2nd harmonic to -60 dB at full cascade (s)
+
+// Polyphony: notes that can sound at once, and the share of the DSP core's
+// block time they may use before the allocator stops adding notes
+constexpr int POLYPHONY = 4;
+constexpr float POLY_CPU_BUDGET = 0.7f;
+
+// Voice memory shared by the active voices, see VoiceArena. Only the
+// pitched verb borrows, one note at a time, so this is one verb's delay
+// lines (4 x 4096 + 2 x 2048 samples plus their state, 80.1 KB)
+constexpr int VOICE_ARENA_BYTES = 82032;
+
+// Crossfade when the voice changes under a sounding note, in audio blocks
+// (8 = ~11.6 ms); 0 switches hard
+constexpr int VOICE_CROSSFADE_BLOCKS = 8;
 
 // Envelope time ranges (seconds)
 constexpr float MIN_ATTACK = 0.001f;
@@ -20,14 +35,30 @@ constexpr float MAX_DECAY = 8.0f;
 
 // Modulation amounts
 constexpr float CV_MOD_AMOUNT = 1.0f;  // Full range CV modulation
+
+// Parameter smoothing (see ParamSmoother): one-pole coefficients per audio
+// block for the pitch knob (~4 ms) and the timbre knobs (~14 ms), and the
+// ramp time of menu and automation steps
 constexpr float PITCH_SMOOTH_ALPHA = 0.3f;
 constexpr float PARAM_SMOOTH_ALPHA = 0.1f;
+constexpr float PARAM_RAMP_MS = 20.0f;
 
 // Output settings
 constexpr float MASTER_GAIN = 0.8f;
 constexpr float SAMPLE_GUARD = 2.0f;
 
 // UI settings
-constexpr int ENCODER_DEBOUNCE_MS = 5;
 constexpr int DISPLAY_UPDATE_MS = 50;
-constexpr int ADC_READ_INTERVAL_MS = 2;
+constexpr int ADC_READ_INTERVAL_MS = 5;   // Knob filter output rate (200 Hz)
+
+// ADC sampling (see AdcStream): conversion ticks per second. Pitch CV is
+// read on every tick; CV0/CV1 and the pots share one read per tick, round
+// robin. The sampler wakes ADC_WAKE_RATE times a second and runs the ticks
+// since its last wakeup as one burst, so the UI core is not woken per
+// conversion. Each channel is decimated by its oversampling factor.
+constexpr int ADC_SAMPLE_RATE = 4000;
+constexpr int ADC_WAKE_RATE = 500;
+constexpr int ADC_BURST = ADC_SAMPLE_RATE / ADC_WAKE_RATE;  // Ticks per wakeup
+constexpr int ADC_CV_OVERSAMPLE = 4;    // Pitch CV out at 1 kHz, two per burst
+constexpr int ADC_KNOB_OVERSAMPLE = 4;  // 800 Hz in, 200 Hz out per channel
+static_assert(ADC_BURST % ADC_CV_OVERSAMPLE == 0, "A burst should end on a pitch CV output");
@@ -0,0 +1,275 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include "Parameters.h"
+#include "Config.h"
+#include "Calibration.h"
+#include "Utils.h"
+
+// Compile-time parameter table
+//
+// One descriptor per ParamId: the ParamMessage field behind it, its range
+// and menu step, how the menus show it, its automation file key and which
+// engine stages it feeds, and how the DSP core smooths it. The menus,
+// automation files and the engine's setters all go through it. setParam()
+// keeps ParamMessage::dirty, so the UI only reformats lines whose
+// parameter changed and the DSP core only re-runs the setters of the
+// stages that did.
+
+enum class ParamKind : uint8_t {
+    LEVEL,   // Shown in percent of the stored value
+    OFFSET,  // Shown in signed percent
+    TIME,    // Shown in ms or s, expMap(value, shownMin, shownMax)
+    CHOICE,  // Enum cycled through choiceNames
+    VOICE,   // Voice ID; names and order come from the voice registry
+    PANEL    // Knob, CV or gate from the panel; not in the menus
+};
+
+// Engine stages, as bits: what to update when the parameter changes
+enum ParamStage : uint8_t {
+    STAGE_NONE = 0,
+    STAGE_VOICE_SELECT = 1 << 0,
+    STAGE_ENVELOPE = 1 << 1,
+    STAGE_VOICE = 1 << 2,   // The selected voice's controls (VoiceTraits::apply)
+    STAGE_PITCH = 1 << 3,
+    STAGE_GATE = 1 << 4
+};
+
+// How a new value reaches the DSP (see ParamSmoother.h)
+enum class SmoothMode : uint8_t {
+    STEP,     // Applied as it arrives
+    LINEAR,   // Straight ramp over `smoothing` ms
+    ONE_POLE  // Exponential approach; `smoothing` is the coefficient per audio block
+};
+
+struct ParamDesc {
+    ParamId id;
+    const char* key;    // Automation files ("attack")
+    const char* label;  // Menus ("Attack")
+    ParamKind kind;
+    uint8_t stages;
+    float min;
+    float max;
+    float step;         // Per detent, scaled by encoder acceleration
+    float shownMin;     // TIME: ms at 0
+    float shownMax;     // TIME: ms at 1
+    float ParamMessage::* value;
+    uint8_t ParamMessage::* choice;
+    bool ParamMessage::* flag;
+    const char* const* choiceNames;
+    int choiceCount;
+    SmoothMode smoothMode;
+    float smoothing;
+};
+
+constexpr float kParamStep = 0.04f;
+
+inline constexpr const char* kEnvCurveNames[] = {"Exp", "Log", "Linear"};
+inline constexpr const char* kVerbModeNames[] = {"Comb", "FDN"};
+
+static_assert(sizeof(kEnvCurveNames) / sizeof(kEnvCurveNames[0]) == static_cast<size_t>(EnvelopeCurve::NUM_CURVES),
+              "one name per envelope curve");
+static_assert(sizeof(kVerbModeNames) / sizeof(kVerbModeNames[0]) == static_cast<size_t>(VerbMode::NUM_MODES),
+              "one name per verb mode");
+
+constexpr ParamDesc levelParam(ParamId id, const char* key, const char* label, float ParamMessage::* value,
+                               uint8_t stages, float min = 0.0f, float max = 1.0f) {
+    return ParamDesc{id, key, label, ParamKind::LEVEL, stages, min, max, kParamStep, 0.0f, 0.0f,
+                     value, nullptr, nullptr, nullptr, 0, SmoothMode::STEP, 0.0f};
+}
+
+constexpr ParamDesc offsetParam(ParamId id, const char* key, const char* label, float ParamMessage::* value,
+                                uint8_t stages) {
+    return ParamDesc{id, key, label, ParamKind::OFFSET, stages, -1.0f, 1.0f, kParamStep, 0.0f, 0.0f,
+                     value, nullptr, nullptr, nullptr, 0, SmoothMode::STEP, 0.0f};
+}
+
+constexpr ParamDesc timeParam(ParamId id, const char* key, const char* label, float ParamMessage::* value,
+                              uint8_t stages, float minSeconds, float maxSeconds) {
+    return ParamDesc{id, key, label, ParamKind::TIME, stages, 0.0f, 1.0f, kParamStep,
+                     minSeconds * 1000.0f, maxSeconds * 1000.0f, value, nullptr, nullptr, nullptr, 0, SmoothMode::STEP, 0.0f};
+}
+
+template<int N>
+constexpr ParamDesc choiceParam(ParamId id, const char* key, const char* label, uint8_t ParamMessage::* choice,
+                                uint8_t stages, const char* const (&names)[N]) {
+    return ParamDesc{id, key, label, ParamKind::CHOICE, stages, 0.0f, static_cast<float>(N - 1), 1.0f, 0.0f, 0.0f,
+                     nullptr, choice, nullptr, names, N, SmoothMode::STEP, 0.0f};
+}
+
+constexpr ParamDesc voiceParam(ParamId id, const char* key, const char* label, uint8_t ParamMessage::* choice,
+                               uint8_t stages) {
+    return ParamDesc{id, key, label, ParamKind::VOICE, stages, 0.0f,
+                     static_cast<float>(static_cast<int>(VoiceType::NUM_VOICES) - 1), 1.0f, 0.0f, 0.0f,
+                     nullptr, choice, nullptr, nullptr, 0, SmoothMode::STEP, 0.0f};
+}
+
+constexpr ParamDesc panelParam(ParamId id, const char* key, float ParamMessage::* value, uint8_t stages) {
+    return ParamDesc{id, key, key, ParamKind::PANEL, stages, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f,
+                     value, nullptr, nullptr, nullptr, 0, SmoothMode::STEP, 0.0f};
+}
+
+constexpr ParamDesc flagParam(ParamId id, const char* key, bool ParamMessage::* flag, uint8_t stages) {
+    return ParamDesc{id, key, key, ParamKind::PANEL, stages, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f,
+                     nullptr, nullptr, flag, nullptr, 0, SmoothMode::STEP, 0.0f};
+}
+
+constexpr ParamDesc smoothed(ParamDesc desc, SmoothMode mode, float smoothing) {
+    desc.smoothMode = mode;
+    desc.smoothing = smoothing;
+    return desc;
+}
+
+// Levels that move in menu or automation steps ramp over PARAM_RAMP_MS
+constexpr ParamDesc rampParam(ParamDesc desc) {
+    return smoothed(desc, SmoothMode::LINEAR, PARAM_RAMP_MS);
+}
+
+constexpr float kBlockMs = AUDIO_BLOCK_SIZE * 1000.0f / SAMPLE_RATE;
+
+// In ParamId order. The knobs settle with the one-pole coefficients from
+// Config.h; pitch CV, read once per block, is interpolated across it.
+inline constexpr ParamDesc kParams[] = {
+    timeParam(ParamId::ATTACK, "attack", "Attack", &ParamMessage::attack, STAGE_ENVELOPE, MIN_ATTACK, MAX_ATTACK),
+    // Decay is also the gate-off fade at full sustain (see Envelope.h);
+    // near full it turns on drone mode
+    timeParam(ParamId::DECAY, "decay", "Decay", &ParamMessage::decay, STAGE_ENVELOPE | STAGE_GATE,
+              MIN_DECAY, MAX_DECAY),
+    rampParam(levelParam(ParamId::WAVEFOLD, "wavefold", "Wavefold", &ParamMessage::wavefold, STAGE_VOICE)),
+    rampParam(levelParam(ParamId::CHAOS, "chaos", "Chaos", &ParamMessage::chaos, STAGE_VOICE)),
+    rampParam(levelParam(ParamId::FM_FEEDBACK, "fmFeedback", "Feedback", &ParamMessage::fmFeedback, STAGE_VOICE)),
+    rampParam(levelParam(ParamId::FM_FOLD, "fmFold", "Fold", &ParamMessage::fmFold, STAGE_VOICE)),
+    rampParam(levelParam(ParamId::VERB_MIX, "verbMix", "Mix", &ParamMessage::verbMix, STAGE_VOICE)),
+    levelParam(ParamId::VERB_EXCITE, "verbExcite", "Excite", &ParamMessage::verbExcite, STAGE_VOICE),
+    voiceParam(ParamId::VOICE, "voice", "Voice", &ParamMessage::voice, STAGE_VOICE_SELECT),
+    panelParam(ParamId::CV0, "cv0", &ParamMessage::cv0, STAGE_NONE),
+    panelParam(ParamId::CV1, "cv1", &ParamMessage::cv1, STAGE_NONE),
+    smoothed(panelParam(ParamId::CV2, "cv2", &ParamMessage::cv2, STAGE_PITCH), SmoothMode::LINEAR, kBlockMs),
+    smoothed(panelParam(ParamId::POT0, "pot0", &ParamMessage::pot0, STAGE_VOICE),
+             SmoothMode::ONE_POLE, PARAM_SMOOTH_ALPHA),
+    smoothed(panelParam(ParamId::POT1, "pot1", &ParamMessage::pot1, STAGE_VOICE),
+             SmoothMode::ONE_POLE, PARAM_SMOOTH_ALPHA),
+    smoothed(panelParam(ParamId::POT2, "pot2", &ParamMessage::pot2, STAGE_PITCH),
+             SmoothMode::ONE_POLE, PITCH_SMOOTH_ALPHA),
+    rampParam(offsetParam(ParamId::CV_PITCH_OFFSET, "cvPitchOffset", "Offset", &ParamMessage::cvPitchOffset,
+                          STAGE_PITCH)),
+    rampParam(levelParam(ParamId::CV_PITCH_SCALE, "cvPitchScale", "Scale", &ParamMessage::cvPitchScale,
+                         STAGE_PITCH, 0.0f, 2.0f)),
+    flagParam(ParamId::GATE, "gate", &ParamMessage::gateIn, STAGE_GATE),
+    levelParam(ParamId::SUSTAIN, "sustain", "Sustain", &ParamMessage::sustain, STAGE_ENVELOPE),
+    timeParam(ParamId::RELEASE, "release", "Release", &ParamMessage::release, STAGE_ENVELOPE,
+              MIN_DECAY, MAX_DECAY),
+    choiceParam(ParamId::ENV_CURVE, "envCurve", "Curve", &ParamMessage::envCurve, STAGE_ENVELOPE, kEnvCurveNames),
+    choiceParam(ParamId::VERB_MODE, "verbMode", "Mode", &ParamMessage::verbMode, STAGE_VOICE, kVerbModeNames),
+};
+
+constexpr bool paramTableInOrder() {
+    for (int i = 0; i < static_cast<int>(ParamId::NUM_PARAMS); ++i) {
+        if (static_cast<int>(kParams[i].id) != i) return false;
+    }
+    return true;
+}
+
+static_assert(sizeof(kParams) / sizeof(kParams[0]) == static_cast<size_t>(ParamId::NUM_PARAMS),
+              "one descriptor per ParamId");
+static_assert(paramTableInOrder(), "kParams must be in ParamId order");
+
+constexpr bool paramSmoothingValid() {
+    for (const ParamDesc& desc : kParams) {
+        if (desc.smoothMode != SmoothMode::STEP && desc.value == nullptr) return false;
+    }
+    return true;
+}
+
+static_assert(paramSmoothingValid(), "only float parameters can be smoothed");
+
+constexpr const ParamDesc& paramDesc(ParamId id) {
+    return kParams[static_cast<int>(id)];
+}
+
+// Parameters that feed any of the given stages
+constexpr ParamMask paramsFeeding(uint8_t stages) {
+    ParamMask mask = 0;
+    for (const ParamDesc& desc : kParams) {
+        if (desc.stages & stages) mask |= paramBit(desc.id);
+    }
+    return mask;
+}
+
+inline float getParam(const ParamMessage& params, ParamId id) {
+    const ParamDesc& desc = paramDesc(id);
+    if (desc.value) return params.*desc.value;
+    if (desc.choice) return static_cast<float>(params.*desc.choice);
+    return params.*desc.flag ? 1.0f : 0.0f;
+}
+
+// Store a value and mark it dirty if it changed; returns whether it did.
+// Values are stored as given (choices truncated, the gate high from 0.5).
+inline bool setParam(ParamMessage& params, ParamId id, float value) {
+    const ParamDesc& desc = paramDesc(id);
+    bool changed = false;
+    if (desc.value) {
+        changed = assignIfChanged(params.*desc.value, value);
+    } else if (desc.choice) {
+        changed = assignIfChanged(params.*desc.choice, static_cast<uint8_t>(value));
+    } else {
+        changed = assignIfChanged(params.*desc.flag, value >= 0.5f);
+    }
+    if (changed) params.dirty |= paramBit(id);
+    return changed;
+}
+
+// Menu edit: levels move by the accelerated count within their range,
+// choices one entry per detent, wrapping. VOICE is stepped by the caller,
+// which knows which voices are built in.
+inline bool adjustParam(ParamMessage& params, ParamId id, int detents, int accelerated) {
+    const ParamDesc& desc = paramDesc(id);
+    if (desc.kind == ParamKind::CHOICE) {
+        int next = (static_cast<int>(params.*desc.choice) + detents) % desc.choiceCount;
+        return setParam(params, id, static_cast<float>(next < 0 ? next + desc.choiceCount : next));
+    }
+    if (desc.kind == ParamKind::VOICE || desc.kind == ParamKind::PANEL) return false;
+    float next = params.*desc.value + desc.step * static_cast<float>(accelerated);
+    return setParam(params, id, clamp(next, desc.min, desc.max));
+}
+
+// "<label>: <value>" as the menus show it
+inline void formatParam(const ParamMessage& params, ParamId id, char* out, size_t size) {
+    const ParamDesc& desc = paramDesc(id);
+    switch (desc.kind) {
+        case ParamKind::LEVEL:
+            snprintf(out, size, "%s: %.0f%%", desc.label, params.*desc.value * 100.0f);
+            break;
+        case ParamKind::OFFSET:
+            snprintf(out, size, "%s: %+.0f%%", desc.label, params.*desc.value * 100.0f);
+            break;
+        case ParamKind::TIME: {
+            float ms = expMap(params.*desc.value, desc.shownMin, desc.shownMax);
+            if (ms >= 1000.0f) {
+                snprintf(out, size, "%s: %.1fs", desc.label, ms / 1000.0f);
+            } else {
+                snprintf(out, size, "%s: %.0fms", desc.label, ms);
+            }
+            break;
+        }
+        case ParamKind::CHOICE: {
+            int choice = params.*desc.choice;
+            if (choice >= desc.choiceCount) choice = 0;
+            snprintf(out, size, "%s: %s", desc.label, desc.choiceNames[choice]);
+            break;
+        }
+        default:
+            snprintf(out, size, "%s: %.2f", desc.label, getParam(params, id));
+            break;
+    }
+}
+
+// ParamId for an automation key, or -1
+inline int findParamKey(const char* key) {
+    for (const ParamDesc& desc : kParams) {
+        if (std::strcmp(key, desc.key) == 0) return static_cast<int>(desc.id);
+    }
+    return -1;
+}
@@ -10,18 +10,77 @@ enum class VoiceType : uint8_t {
     NUM_VOICES
 };
 
+// PitchedVerb resonator structure
+enum class VerbMode : uint8_t {
+    COMB = 0,
+    FDN,
+    NUM_MODES
+};
+
+// Envelope segment shape
+enum class EnvelopeCurve : uint8_t {
+    EXP = 0,
+    LOG,
+    LINEAR,
+    NUM_CURVES
+};
+
+// Every ParamMessage field. The numbering is also the field ID in binary
+// automation files, so new parameters go at the end. Ranges, labels and
+// formatting are in ParamTable.h.
+enum class ParamId : uint8_t {
+    ATTACK = 0,
+    DECAY,
+    WAVEFOLD,
+    CHAOS,
+    FM_FEEDBACK,
+    FM_FOLD,
+    VERB_MIX,
+    VERB_EXCITE,
+    VOICE,
+    CV0,
+    CV1,
+    CV2,
+    POT0,
+    POT1,
+    POT2,
+    CV_PITCH_OFFSET,
+    CV_PITCH_SCALE,
+    GATE,
+    SUSTAIN,
+    RELEASE,
+    ENV_CURVE,
+    VERB_MODE,
+    NUM_PARAMS
+};
+
+// One bit per ParamId
+using ParamMask = uint32_t;
+
+constexpr ParamMask paramBit(ParamId id) {
+    return static_cast<ParamMask>(1) << static_cast<int>(id);
+}
+
+constexpr ParamMask kAllParams = (static_cast<ParamMask>(1) << static_cast<int>(ParamId::NUM_PARAMS)) - 1;
+
+static_assert(static_cast<int>(ParamId::NUM_PARAMS) <= 32, "ParamMask has one bit per parameter");
+
 // Parameter message for inter-core communication
 struct ParamMessage {
     // Normalized values 0.0 - 1.0
     float attack;
     float decay;
+    float sustain;   // Level, not a time
+    float release;
     float wavefold;
     float chaos;
     float fmFeedback;
     float fmFold;
     float verbMix;
     float verbExcite;
+    uint8_t verbMode;
     uint8_t voice;
+    uint8_t envCurve;
 
     // CV and pot inputs (normalized)
     float cv0;      // Unused (reserved for future)
@@ -35,13 +94,57 @@ struct ParamMessage {
     float cvPitchOffset;  // -1.0 to 1.0, added to CV
     float cvPitchScale;   // 0.0 to 2.0, multiplier for CV
 
-    // Gate state
+    // Gate from the parameter stream (host automation). The gate jack
+    // reaches the DSP as timestamped edges instead; see DspTask.
     bool gateIn;
+
+    // Fields changed since the previous publication (see setParam())
+    ParamMask dirty;
 };
 
+// Power-on parameter state, shared by the DSP task and host tools
+inline ParamMessage makeDefaultParams() {
+    ParamMessage params{};
+    params.attack = 0.1f;
+    params.decay = 0.5f;
+    params.sustain = 1.0f;
+    params.release = 0.5f;
+    params.wavefold = 0.0f;
+    params.chaos = 0.0f;
+    params.fmFeedback = 0.2f;
+    params.fmFold = 0.0f;
+    params.verbMix = 0.6f;
+    params.verbExcite = 0.5f;
+    params.verbMode = static_cast<uint8_t>(VerbMode::COMB);
+    params.voice = static_cast<uint8_t>(VoiceType::CASCADE);
+    params.envCurve = static_cast<uint8_t>(EnvelopeCurve::EXP);
+    params.cv0 = 0.5f;
+    params.cv1 = 0.5f;
+    params.cv2 = 0.5f;
+    params.pot0 = 0.5f;
+    params.pot1 = 0.5f;
+    params.pot2 = 0.5f;
+    params.cvPitchOffset = 0.0f;
+    params.cvPitchScale = 1.0f;
+    params.gateIn = false;
+    params.dirty = kAllParams;
+    return params;
+}
+
 // Status message from DSP to UI
 struct StatusMessage {
     float outputLevel;
     bool isPlaying;
     float currentFreq;
+
+    // DSP load in percent of the block period: block render time averaged
+    // and peak over the last status interval, and the measured cost of one
+    // note of each voice (by VoiceType; 0 until that voice has played)
+    float loadAvg;
+    float loadPeak;
+    float voiceLoad[static_cast<int>(VoiceType::NUM_VOICES)];
+    uint8_t notes;
+    uint8_t polyLimit;
+    uint32_t deadlineMisses;  // Blocks that took longer than a block period
+    uint32_t underruns;       // Blocks the I2S DMA ran out of samples
 };
@@ -9,6 +9,15 @@ inline T clamp(T value, T minVal, T maxVal) {
     return value;
 }
 
+// Assign only when the value differs; returns true if it changed.
+// Used by control-rate setters to mark derived coefficients dirty.
+template<typename T>
+inline bool assignIfChanged(T& target, T value) {
+    if (target == value) return false;
+    target = value;
+    return true;
+}
+
 // Fast approximation of tanh for soft clipping
 inline float fastTanh(float x) {
     if (x < -3.0f) return -1.0f;
@@ -1,198 +1,288 @@
 #pragma once
 
-#include "HarmonicCascade.h"
-#include "OrbitFm.h"
-#include "PitchedVerb.h"
-#include "Envelope.h"
+#include <cstdint>
+#include <utility>
+#include "NoteEvent.h"
+#include "PolyVoice.h"
+#include "Voices.h"
+#include "VoiceArena.h"
 #include "Config.h"
 #include "Parameters.h"
+#include "ParamTable.h"
+#include "ParamSmoother.h"
 #include "Utils.h"
+#include "../hal/CycleCounter.h"
 
 // Main synthesis engine for Claudius
-// Combines HarmonicCascade oscillator with Envelope
+// A pool of POLYPHONY slots, each playing the selected voice (Voices.h)
+// with its own envelope. Every gate or note-on starts a note in a free
+// slot, or steals one: released notes first, then the quietest, then the
+// oldest. The newest note follows the pitch control; older notes keep the
+// pitch they started with. Sounding slots are rendered a block at a time
+// and summed; when several notes are loud together the sum is scaled by
+// 1/sqrt(sum of squared envelope levels), so a single note is untouched
+// and a chord stays in range.
+//
+// Voices with large state borrow it from arena_ while they are selected,
+// so their memory is shared rather than reserved per voice; slots that
+// find no room sit out, which caps polyphony for memory-hungry voices.
+// With a cycle budget set, the measured cost of a voice block also caps
+// how many notes may sound at once; notes over the cap are faded out
+// quickly, in stealing order.
+//
+// Changing the voice crossfades each sounding note from the old voice to
+// the new one over crossfadeSamples_ (see PolyVoice::select), so a slot
+// renders two voices only for the length of the fade. Those blocks are
+// left out of the per-note cost estimate and show up in the block cycle
+// peak instead.
+//
+// Knobs, pitch CV and the timbre levels are smoothed (ParamSmoother, with
+// the modes in ParamTable.h): a new value glides in over a few blocks, the
+// setters follow once per block while it moves, and the voice renders the
+// controls it can take per sample from the ramp.
+//
+// The gate is the OR of the gate jack (setGateInput, or GATE_ON/GATE_OFF
+// events placed on their sample), ParamMessage::gateIn and drone mode.
 
 class ClaudiusEngine {
 public:
     explicit ClaudiusEngine(float sampleRate = SAMPLE_RATE)
-        : oscillator_(sampleRate)
-        , fmOsc_(sampleRate)
-        , verbOsc_(sampleRate)
-        , envelope_(sampleRate)
-        , frequency_(220.0f)
-        , harmonicSpread_(0.5f)
-        , cascadeRate_(0.5f)
-        , wavefold_(0.0f)
-        , chaos_(0.0f)
-        , fmIndex_(0.5f)
-        , fmRatio_(0.5f)
-        , fmFeedback_(0.2f)
-        , fmFold_(0.0f)
-        , verbFeedback_(0.4f)
-        , verbDamp_(0.3f)
-        , verbMix_(0.6f)
-        , verbExcite_(0.5f)
-        , voice_(VoiceType::CASCADE)
-        , lastVoice_(VoiceType::CASCADE)
-        , gateState_(false)
-        , smoothedLevel_(0.0f)
+        : ClaudiusEngine(sampleRate, std::make_index_sequence<POLYPHONY>{})
     {
     }
 
+    ClaudiusEngine(const ClaudiusEngine&) = delete;
+    ClaudiusEngine& operator=(const ClaudiusEngine&) = delete;
+
     void setFrequency(float freq) {
         frequency_ = clamp(freq, MIN_FREQ, MAX_FREQ);
-        oscillator_.setFrequency(frequency_);
-        fmOsc_.setFrequency(frequency_);
-        verbOsc_.setFrequency(frequency_);
+        pool_[current_].setFrequency(frequency_);
     }
 
-    void setAttack(float normalized) {
-        envelope_.setAttack(normalized);
+    // Unknown or compiled-out voices are ignored
+    void setVoice(VoiceType voice) {
+        int index = ClaudiusVoices::indexOf(voice);
+        if (index < 0 || index == selected_) return;
+        selectVoice(index);
+        if (ClaudiusVoices::info(selected_).triggerOnSelect && gateState_) {
+            pool_[current_].retrigger();
+        }
     }
 
-    void setDecay(float normalized) {
-        envelope_.setDecay(normalized);
+    // Length of the voice-change crossfade, clamped to
+    // [0, kMaxCrossfadeBlocks]; 0 switches hard
+    void setCrossfadeBlocks(int blocks) {
+        blocks = blocks < 0 ? 0 : (blocks > kMaxCrossfadeBlocks ? kMaxCrossfadeBlocks : blocks);
+        crossfadeSamples_ = blocks * AUDIO_BLOCK_SIZE;
     }
 
-    void setHarmonicSpread(float normalized) {
-        harmonicSpread_ = clamp(normalized, 0.0f, 1.0f);
+    // Cycles per block the voices may use, from platform::cycleCount();
+    // 0 disables the cost cap
+    void setCycleBudget(platform::CycleCount cyclesPerBlock) {
+        cycleBudget_ = static_cast<float>(cyclesPerBlock);
+        updatePolyphonyLimit();
     }
 
-    void setCascadeRate(float normalized) {
-        cascadeRate_ = clamp(normalized, 0.0f, 1.0f);
+    void gate(bool on) {
+        if (on && !gateState_) {
+            // Rising edge - new note at the current pitch
+            startNote();
+        } else if (!on && gateState_) {
+            // Falling edge - release held notes
+            releaseNotes();
+        }
+        gateState_ = on;
     }
 
-    void setWavefold(float normalized) {
-        wavefold_ = clamp(normalized, 0.0f, 1.0f);
+    // Gate jack level
+    void setGateInput(bool high) {
+        gateInput_ = high;
+        updateGate();
     }
 
-    void setChaos(float normalized) {
-        chaos_ = clamp(normalized, 0.0f, 1.0f);
+    void noteOn(float freq) {
+        frequency_ = clamp(freq, MIN_FREQ, MAX_FREQ);
+        pitch_ = -1.0f;  // next applyParams re-derives pitch
+        startNote();
+        gateState_ = true;
     }
 
-    void setFmIndex(float normalized) {
-        fmIndex_ = clamp(normalized, 0.0f, 1.0f);
+    void noteOff() {
+        releaseNotes();
+        gateState_ = false;
     }
 
-    void setFmRatio(float normalized) {
-        fmRatio_ = clamp(normalized, 0.0f, 1.0f);
+    // Apply a parameter snapshot from the UI core. Only the stages fed by
+    // the parameters in `changed` are updated (see ParamTable.h); smoothed
+    // parameters get a new target and move in processBlock().
+    // Pot0/Pot1 and the SHAPE controls go to the selected voice (see
+    // VoiceTraits::apply)
+    // Pot2 = Pitch (0-1)
+    // Only pitch CV is active.
+    void applyParams(const ParamMessage& params, ParamMask changed = kAllParams) {
+        smoother_.setTargets(params, changed);
+        params_ = params;
+        smoother_.writeValues(params_);
+        applyStages(changed);
     }
 
-    void setFmFeedback(float normalized) {
-        fmFeedback_ = clamp(normalized, 0.0f, 1.0f);
+    // Pitch CV (0-1) between parameter snapshots
+    void setPitchCv(float cv) {
+        updateParam(ParamId::CV2, cv);
     }
 
-    void setFmFold(float normalized) {
-        fmFold_ = clamp(normalized, 0.0f, 1.0f);
+    // Pitch CV samples straight from the ADC stream, oldest first: pitch is
+    // ramped through all of them, kPitchCvSpacing samples apart, starting
+    // with the next block
+    void setPitchCv(const float* cv, int count) {
+        smoother_.setPath(ParamId::CV2, cv, count, kPitchCvSpacing);
     }
 
-    void setVoice(VoiceType voice) {
-        if (voice != lastVoice_) {
-            voice_ = voice;
-            if (voice_ == VoiceType::PITCH_VERB && gateState_) {
-                verbOsc_.trigger();
-            }
-            lastVoice_ = voice_;
+    // One parameter outside a snapshot
+    void updateParam(ParamId id, float value) {
+        if (kSmoothedParams & paramBit(id)) {
+            smoother_.setTarget(id, value);
+        } else if (setParam(params_, id, value)) {
+            applyStages(paramBit(id));
         }
     }
 
-    void setVerbFeedback(float normalized) {
-        verbFeedback_ = clamp(normalized, 0.0f, 1.0f);
+    VoiceType getVoice() const {
+        return ClaudiusVoices::info(selected_).type;
     }
 
-    void setVerbDamp(float normalized) {
-        verbDamp_ = clamp(normalized, 0.0f, 1.0f);
+    // Voices of the newest note's slot
+    const ClaudiusVoices& getVoices() const {
+        return pool_[current_].getVoices();
     }
 
-    void setVerbMix(float normalized) {
-        verbMix_ = clamp(normalized, 0.0f, 1.0f);
-    }
-
-    void setVerbExcite(float normalized) {
-        verbExcite_ = clamp(normalized, 0.0f, 1.0f);
-        verbOsc_.setExcite(verbExcite_);
+    // Process one sample
+    float process() {
+        float sample;
+        processBlock(&sample, 1);
+        return sample;
     }
 
-    void gate(bool on) {
-        if (on && !gateState_) {
-            // Rising edge - trigger oscillator and envelope
-            oscillator_.trigger();
-            fmOsc_.trigger();
-            verbOsc_.trigger();
-            envelope_.trigger();
-        } else if (!on && gateState_) {
-            // Falling edge - release envelope
-            envelope_.release();
+    // Render numSamples, applying each event at its offset. Events must be
+    // in offset order; the block is rendered in pieces between them.
+    void processBlock(float* out, int numSamples, const NoteEvent* events, int eventCount) {
+        int pos = 0;
+        for (int i = 0; i < eventCount; ++i) {
+            int offset = clamp(events[i].offset, pos, numSamples);
+            if (offset > pos) {
+                processBlock(out + pos, offset - pos);
+                pos = offset;
+            }
+            handleEvent(events[i]);
+        }
+        if (pos < numSamples) {
+            processBlock(out + pos, numSamples - pos);
         }
-        gateState_ = on;
     }
 
-    void noteOn(float freq) {
-        setFrequency(freq);
-        oscillator_.reset();
-        fmOsc_.reset();
-        verbOsc_.reset();
-        oscillator_.trigger();
-        fmOsc_.trigger();
-        verbOsc_.trigger();
-        envelope_.trigger();
-        gateState_ = true;
-    }
+    // Render numSamples (at most AUDIO_BLOCK_SIZE). Voice dispatch, the
+    // bad-sample guard and the level meter are decided once per block.
+    void processBlock(float* out, int numSamples) {
+        for (int i = 0; i < numSamples; ++i) {
+            out[i] = 0.0f;
+        }
 
-    void noteOff() {
-        envelope_.release();
-        gateState_ = false;
-    }
+        // Pitch is set per render, so while pitch CV is moving the voices
+        // are rendered in short pieces to follow it inside the block
+        bool cvMoving = (smoother_.getMoving() & paramBit(ParamId::CV2)) != 0;
+        int piece = cvMoving ? kPitchStepSamples : numSamples;
+        SlotTotals totals = {};
+        for (int pos = 0; pos < numSamples; pos += piece) {
+            renderSlots(out + pos, piece < numSamples - pos ? piece : numSamples - pos, totals);
+        }
+        sounding_ = totals.rendered;
+        blockCycles_ = totals.cycles;
+        if (totals.cycles > peakBlockCycles_) peakBlockCycles_ = totals.cycles;
+        if (totals.steady > 0 && numSamples == AUDIO_BLOCK_SIZE) {
+            updateVoiceCost(static_cast<float>(totals.noteCycles) / static_cast<float>(totals.steady));
+        }
 
-    // Process one sample, returns stereo pair (for now, same output)
-    float process() {
-        // Get envelope level
-        float envLevel = envelope_.process();
-
-        // Generate audio
-        float sample = 0.0f;
-        if (voice_ == VoiceType::CASCADE) {
-            sample = oscillator_.process(
-                harmonicSpread_,
-                cascadeRate_,
-                wavefold_,
-                chaos_,
-                envLevel
-            );
-        } else if (voice_ == VoiceType::ORBIT_FM) {
-            sample = fmOsc_.process(
-                fmIndex_,
-                fmRatio_,
-                fmFeedback_,
-                fmFold_,
-                envLevel
-            );
-        } else {
-            sample = verbOsc_.process(
-                verbFeedback_,
-                verbDamp_,
-                verbMix_,
-                envLevel
-            );
+        // Mix headroom, ramped across the block
+        float targetGain = (totals.energy > 1.0f) ? 1.0f / sqrtf(totals.energy) : 1.0f;
+        if (targetGain != mixGain_ || mixGain_ != 1.0f) {
+            float gainStep = (targetGain - mixGain_) / static_cast<float>(numSamples);
+            for (int i = 0; i < numSamples; ++i) {
+                mixGain_ += gainStep;
+                out[i] *= mixGain_;
+            }
+            mixGain_ = targetGain;
         }
 
         // Apply master gain
-        sample *= MASTER_GAIN;
+        float sum = 0.0f;
+        for (int i = 0; i < numSamples; ++i) {
+            out[i] *= MASTER_GAIN;
+            sum += out[i];
+        }
 
-        // Guard against bad samples
-        if (!std::isfinite(sample)) {
-            sample = 0.0f;
+        // Guard against bad samples: a NaN/Inf anywhere poisons the sum
+        if (!std::isfinite(sum)) {
+            for (int i = 0; i < numSamples; ++i) {
+                if (!std::isfinite(out[i])) {
+                    out[i] = 0.0f;
+                }
+            }
         }
-        sample = clamp(sample, -SAMPLE_GUARD, SAMPLE_GUARD);
 
-        // Update smoothed level for metering
-        float absSample = fabsf(sample);
-        smoothedLevel_ = smoothedLevel_ * 0.999f + absSample * 0.001f;
+        float absSum = 0.0f;
+        for (int i = 0; i < numSamples; ++i) {
+            out[i] = clamp(out[i], -SAMPLE_GUARD, SAMPLE_GUARD);
+            absSum += fabsf(out[i]);
+        }
 
-        return sample;
+        // Update smoothed level for metering: the per-sample one-pole
+        // (0.999) applied once per block to the block's mean level
+        float meterDecay = (numSamples == AUDIO_BLOCK_SIZE)
+            ? meterBlockDecay_
+            : powf(0.999f, static_cast<float>(numSamples));
+        float meanAbs = absSum / static_cast<float>(numSamples);
+        smoothedLevel_ = smoothedLevel_ * meterDecay + meanAbs * (1.0f - meterDecay);
     }
 
     bool isPlaying() const {
-        return envelope_.isActive();
+        for (const PolyVoice& slot : pool_) {
+            if (slot.isSounding()) return true;
+        }
+        return false;
+    }
+
+    // Slots rendered in the last block
+    int getSoundingVoices() const {
+        return sounding_;
+    }
+
+    // Notes allowed to sound at once under the cycle budget
+    int getPolyphonyLimit() const {
+        return polyLimit_;
+    }
+
+    // Smoothed cycles per block of one note of the selected voice
+    float getVoiceCycles() const {
+        return voiceCycles_[selected_];
+    }
+
+    // The same for the voice at a registry index; 0 until it has played
+    float getVoiceCycles(int index) const {
+        return voiceCycles_[index];
+    }
+
+    // Voice cycles of the last block, all notes and crossfades included
+    platform::CycleCount getBlockCycles() const {
+        return blockCycles_;
+    }
+
+    // Highest getBlockCycles() since the last resetPeakBlockCycles()
+    platform::CycleCount getPeakBlockCycles() const {
+        return peakBlockCycles_;
+    }
+
+    void resetPeakBlockCycles() {
+        peakBlockCycles_ = 0;
     }
 
     float getFrequency() const {
@@ -204,43 +294,285 @@ public:
         return level < 1.0f ? level : 1.0f;
     }
 
+    // Envelope of the newest note
     float getEnvelopeLevel() const {
-        return envelope_.getLevel();
+        return pool_[current_].getEnvelope().getLevel();
     }
 
     Envelope::Stage getEnvelopeStage() const {
-        return envelope_.getStage();
+        return pool_[current_].getEnvelope().getStage();
     }
 
-    void getVerbDelayStats(int &comb0, int &comb1, int &comb2, int &comb3, int &ap0, int &ap1) const {
-        verbOsc_.getDelayStats(comb0, comb1, comb2, comb3, ap0, ap1);
+    const VoiceArena& getArena() const {
+        return arena_;
     }
 
-    float getVerbBaseFreq() const {
-        return verbOsc_.getBaseFreq();
+private:
+    static_assert(POLYPHONY >= 1, "POLYPHONY must be at least 1");
+    static_assert(PitchedVerb::kArenaBytes <= VoiceArena::kCapacity,
+                  "VOICE_ARENA_BYTES too small for the pitched verb");
+    static_assert(VoiceArena::kCapacity - PitchedVerb::kArenaBytes < VoiceArena::kAlignment,
+                  "VOICE_ARENA_BYTES larger than the pitched verb borrows");
+
+    // Smoothing of the per-note cost estimate (per block)
+    static constexpr float kCostSmoothing = 0.05f;
+
+    // Pitch CV samples arrive 1/(ADC_SAMPLE_RATE/ADC_CV_OVERSAMPLE) apart
+    // (~44 samples); pitch follows them in steps of kPitchStepSamples
+    static constexpr int kPitchCvSpacing =
+        static_cast<int>(SAMPLE_RATE * ADC_CV_OVERSAMPLE / ADC_SAMPLE_RATE + 0.5f);
+    static constexpr int kPitchStepSamples = 16;
+
+    // Longest voice-change crossfade (~46 ms)
+    static constexpr int kMaxCrossfadeBlocks = 32;
+    static constexpr ParamMask kVoiceSelectParams = paramsFeeding(STAGE_VOICE_SELECT);
+    static constexpr ParamMask kSlotParams = paramsFeeding(STAGE_ENVELOPE | STAGE_VOICE);
+    static constexpr ParamMask kPitchParams = paramsFeeding(STAGE_PITCH);
+    static constexpr ParamMask kGateParams = paramsFeeding(STAGE_GATE);
+
+    template<size_t... Slot>
+    ClaudiusEngine(float sampleRate, std::index_sequence<Slot...>)
+        : pool_{PolyVoice(arena_, ((void)Slot, sampleRate))...}
+        , frequency_(220.0f)
+        , pitch_(-1.0f)
+        , params_(makeDefaultParams())
+        , smoother_(sampleRate)
+        , selected_(-1)
+        , current_(0)
+        , noteCount_(0)
+        , gateState_(false)
+        , gateInput_(false)
+        , paramGate_(false)
+        , drone_(false)
+        , sounding_(0)
+        , cycleBudget_(0.0f)
+        , polyLimit_(POLYPHONY)
+        , crossfadeSamples_(0)
+        , blockCycles_(0)
+        , peakBlockCycles_(0)
+        , mixGain_(1.0f)
+        , smoothedLevel_(0.0f)
+        , meterBlockDecay_(powf(0.999f, static_cast<float>(AUDIO_BLOCK_SIZE)))
+    {
+        for (float& cycles : voiceCycles_) {
+            cycles = 0.0f;
+        }
+        selectVoice(0);
+        setCrossfadeBlocks(VOICE_CROSSFADE_BLOCKS);
     }
 
-private:
-    HarmonicCascade oscillator_;
-    OrbitFm fmOsc_;
-    PitchedVerb verbOsc_;
-    Envelope envelope_;
+    // Move every slot to another voice. The newest note's slot borrows
+    // first so it keeps sounding when the new voice only fits once;
+    // sounding slots crossfade, and hold the old voice's memory until
+    // their fade is over.
+    void selectVoice(int index) {
+        selected_ = index;
+        pool_[current_].select(index, crossfadeSamples_);
+        for (int i = 0; i < POLYPHONY; ++i) {
+            if (i != current_) pool_[i].select(index, crossfadeSamples_);
+        }
+        updatePolyphonyLimit();
+    }
+
+    // Run the setters of the stages fed by `changed`, from params_
+    void applyStages(ParamMask changed) {
+        if (changed & kVoiceSelectParams) {
+            int previous = selected_;
+            setVoice(static_cast<VoiceType>(params_.voice));
+            // The new voice has not seen the current controls
+            if (selected_ != previous) changed |= kSlotParams;
+        }
+        if (changed & kSlotParams) {
+            for (PolyVoice& slot : pool_) {
+                slot.applyParams(params_, changed);
+            }
+        }
+
+        if (changed & kPitchParams) {
+            updatePitch();
+        }
+
+        if (changed & kGateParams) {
+            // Drone mode when decay > 98%
+            paramGate_ = params_.gateIn;
+            drone_ = (params_.decay > 0.98f);
+            updateGate();
+        }
+    }
+
+    void handleEvent(const NoteEvent& event) {
+        switch (event.type) {
+            case NoteEvent::Type::GATE_ON: setGateInput(true); break;
+            case NoteEvent::Type::GATE_OFF: setGateInput(false); break;
+            case NoteEvent::Type::NOTE_ON: noteOn(event.frequency); break;
+            case NoteEvent::Type::NOTE_OFF: noteOff(); break;
+        }
+    }
+
+    void updatePitch() {
+        constexpr float kPitchOctaves = 5.0f;
+        // Apply CV offset and scale (hardware CV inversion handled by pitch inversion below)
+        float cvPitch = (params_.cv2 - 0.5f) * params_.cvPitchScale + params_.cvPitchOffset;
+        float pitch = params_.pot2 + cvPitch;
+        pitch = clamp(pitch, 0.0f, 1.0f);
+        pitch = 1.0f - pitch;
+        // Exponential pitch mapping only when the pitch control moved
+        if (assignIfChanged(pitch_, pitch)) {
+            setFrequency(MIN_FREQ * powf(2.0f, pitch * kPitchOctaves));
+        }
+    }
+
+    void updateGate() {
+        gate(gateInput_ || paramGate_ || drone_);
+    }
+
+    void startNote() {
+        int slot = allocateSlot();
+        pool_[slot].noteOn(frequency_, ++noteCount_);
+        current_ = slot;
+    }
+
+    void releaseNotes() {
+        for (PolyVoice& slot : pool_) {
+            if (slot.isHeld()) slot.noteOff();
+        }
+    }
+
+    // A free slot while under the polyphony limit, otherwise the sounding
+    // slot that is cheapest to lose
+    int allocateSlot() const {
+        int sounding = 0;
+        int idle = -1;
+        for (int i = 0; i < POLYPHONY; ++i) {
+            if (!pool_[i].isAvailable()) continue;
+            if (pool_[i].isSounding()) {
+                ++sounding;
+            } else if (idle < 0) {
+                idle = i;
+            }
+        }
+        if (idle >= 0 && sounding < polyLimit_) return idle;
+
+        int victim = -1;
+        for (int i = 0; i < POLYPHONY; ++i) {
+            if (!pool_[i].isSounding()) continue;
+            if (victim < 0 || stealBefore(pool_[i], pool_[victim])) victim = i;
+        }
+        if (victim >= 0) return victim;
+        return idle >= 0 ? idle : current_;
+    }
+
+    // Cycle accounting of the pieces of one block
+    struct SlotTotals {
+        platform::CycleCount cycles;
+        platform::CycleCount noteCycles;  // Of the slots not crossfading
+        int rendered;  // Counts and energy are those of the last piece
+        int steady;
+        float energy;
+    };
+
+    // Move the smoothed parameters by numSamples and mix the sounding
+    // slots into out, timing each one
+    void renderSlots(float* out, int numSamples, SlotTotals& totals) {
+        ParamMask moved = smoother_.process(numSamples);
+        if (moved != 0) {
+            smoother_.writeValues(params_);
+            applyStages(moved);
+        }
+        ParamRamps ramps = smoother_.getRamps();
+
+        enforcePolyphonyLimit();
+
+        totals.rendered = 0;
+        totals.steady = 0;
+        totals.energy = 0.0f;
+        for (PolyVoice& slot : pool_) {
+            if (!slot.isSounding()) continue;
+            bool switching = slot.isSwitching();
+            platform::CycleCount start = platform::cycleCount();
+            slot.render(voiceOut_, numSamples, ramps);
+            for (int i = 0; i < numSamples; ++i) {
+                out[i] += voiceOut_[i];
+            }
+            platform::CycleCount cycles = platform::cycleCount() - start;
+            totals.cycles += cycles;
+            ++totals.rendered;
+            // A crossfading slot runs two voices; keep it out of the
+            // per-note estimate
+            if (!switching) {
+                totals.noteCycles += cycles;
+                ++totals.steady;
+            }
+            float level = slot.getEnvelope().getLevel();
+            totals.energy += level * level;
+        }
+    }
+
+    // Choke notes beyond the limit; ones already fading do not count
+    void enforcePolyphonyLimit() {
+        int sounding = 0;
+        for (const PolyVoice& slot : pool_) {
+            if (slot.isSounding() && !slot.isChoked()) ++sounding;
+        }
+        while (sounding > polyLimit_) {
+            int victim = -1;
+            for (int i = 0; i < POLYPHONY; ++i) {
+                if (!pool_[i].isSounding() || pool_[i].isChoked()) continue;
+                if (victim < 0 || stealBefore(pool_[i], pool_[victim])) victim = i;
+            }
+            pool_[victim].choke();
+            --sounding;
+        }
+    }
+
+    // Released notes go first, then the quietest, then the oldest
+    static bool stealBefore(const PolyVoice& a, const PolyVoice& b) {
+        if (a.isHeld() != b.isHeld()) return !a.isHeld();
+        float levelA = a.getEnvelope().getLevel();
+        float levelB = b.getEnvelope().getLevel();
+        if (levelA != levelB) return levelA < levelB;
+        return a.getStartOrder() < b.getStartOrder();
+    }
+
+    void updateVoiceCost(float cyclesPerNote) {
+        float& cost = voiceCycles_[selected_];
+        cost = (cost > 0.0f) ? cost + (cyclesPerNote - cost) * kCostSmoothing : cyclesPerNote;
+        updatePolyphonyLimit();
+    }
+
+    void updatePolyphonyLimit() {
+        float cost = voiceCycles_[selected_];
+        if (cycleBudget_ <= 0.0f || cost <= 0.0f) {
+            polyLimit_ = POLYPHONY;
+            return;
+        }
+        int fit = static_cast<int>(cycleBudget_ / cost);
+        polyLimit_ = fit < 1 ? 1 : (fit > POLYPHONY ? POLYPHONY : fit);
+    }
+
+    VoiceArena arena_;
+    PolyVoice pool_[POLYPHONY];
 
     float frequency_;
-    float harmonicSpread_;
-    float cascadeRate_;
-    float wavefold_;
-    float chaos_;
-    float fmIndex_;
-    float fmRatio_;
-    float fmFeedback_;
-    float fmFold_;
-    float verbFeedback_;
-    float verbDamp_;
-    float verbMix_;
-    float verbExcite_;
-    VoiceType voice_;
-    VoiceType lastVoice_;
+    float pitch_;
+    ParamMessage params_;     // Latest snapshot, smoothed parameters where they are now
+    ParamSmoother smoother_;
+    int selected_;  // Registry index of the selected voice
+    int current_;   // Slot of the newest note
+    uint32_t noteCount_;
     bool gateState_;
+    bool gateInput_;
+    bool paramGate_;
+    bool drone_;
+    int sounding_;
+    float cycleBudget_;
+    int polyLimit_;
+    int crossfadeSamples_;
+    platform::CycleCount blockCycles_;
+    platform::CycleCount peakBlockCycles_;
+    float voiceCycles_[ClaudiusVoices::kCount];
+    float mixGain_;
     float smoothedLevel_;
+    float meterBlockDecay_;
+    float voiceOut_[AUDIO_BLOCK_SIZE];  // One slot's block, before mixing
 };
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include "Utils.h"
+
+// Circular delay line with a power-of-two capacity, so wrapping is a mask
+// instead of a modulo.
+//
+// read(d) returns the sample written d writes ago, linearly interpolated
+// for fractional d (1 <= d <= N - 2). The line also keeps a gliding delay
+// time: setDelay() sets a target, and tap() moves the current delay one
+// one-pole step towards it before reading, so retuning sweeps smoothly
+// instead of jumping.
+
+template<typename T, int N>
+class DelayLine {
+    static_assert(N >= 4 && (N & (N - 1)) == 0, "DelayLine size must be a power of two");
+
+public:
+    static constexpr int kCapacity = N;
+    static constexpr float kMaxDelay = static_cast<float>(N - 2);
+
+    DelayLine()
+        : writeIndex_(0)
+        , delay_(1.0f)
+        , targetDelay_(1.0f)
+        , glide_(1.0f)
+    {
+    }
+
+    void clear() {
+        for (int i = 0; i < N; ++i) {
+            buffer_[i] = T();
+        }
+        writeIndex_ = 0;
+    }
+
+    void write(T value) {
+        buffer_[writeIndex_] = value;
+        writeIndex_ = (writeIndex_ + 1) & kMask;
+    }
+
+    T read(int delay) const {
+        return buffer_[(writeIndex_ - delay) & kMask];
+    }
+
+    T read(float delay) const {
+        int whole = static_cast<int>(delay);
+        float frac = delay - static_cast<float>(whole);
+        T a = buffer_[(writeIndex_ - whole) & kMask];
+        T b = buffer_[(writeIndex_ - whole - 1) & kMask];
+        return a + (b - a) * frac;
+    }
+
+    // Per-sample one-pole coefficient for delay changes (1 = jump)
+    void setGlide(float coeff) {
+        glide_ = clamp(coeff, 0.0f, 1.0f);
+    }
+
+    void setDelay(float delay) {
+        targetDelay_ = clamp(delay, 1.0f, kMaxDelay);
+    }
+
+    // Jump straight to the target delay
+    void snap() {
+        delay_ = targetDelay_;
+    }
+
+    T tap() {
+        delay_ += (targetDelay_ - delay_) * glide_;
+        return read(delay_);
+    }
+
+    float getDelay() const {
+        return delay_;
+    }
+
+private:
+    static constexpr int kMask = N - 1;
+
+    T buffer_[N];
+    int writeIndex_;
+    float delay_;
+    float targetDelay_;
+    float glide_;
+};
@@ -1,144 +1,187 @@
 #pragma once
 
-#include <Arduino.h>
-#include <freertos/FreeRTOS.h>
-#include <freertos/queue.h>
+#include <cstdio>
 #include "ClaudiusEngine.h"
+#include "NoteEvent.h"
 #include "Parameters.h"
 #include "Config.h"
 #include "Calibration.h"
 #include "Utils.h"
+#include "../hal/Adc.h"
 #include "../hal/AudioOutput.h"
+#include "../hal/CycleCounter.h"
 #include "../hal/Gate.h"
+#include "../hal/Mailbox.h"
+#include "../hal/Platform.h"
+#include "../hal/TripleBuffer.h"
 
-extern QueueHandle_t gParamQueue;
-extern QueueHandle_t gStatusQueue;
+extern TripleBuffer<ParamMessage> gParamBuffer;
+extern Adc gAdc;
+extern Mailbox<StatusMessage> gStatusQueue;
+
+// Gate edge timing. Each edge is played one block period after it
+// happened, on its own sample; what varies is how long it waited for the
+// DSP (age) and how evenly blocks start (jitter), which is the remaining
+// error in where edges land.
+struct GateEventStats {
+    uint32_t count = 0;
+    uint32_t late = 0;         // Older than a block, played at the block start
+    uint32_t resynced = 0;     // Edges made up after the queue dropped some
+    uint64_t sumAgeUs = 0;
+    uint32_t maxAgeUs = 0;
+    uint32_t maxJitterUs = 0;  // Block start deviation from the block period
+
+    float avgAgeUs() const {
+        return count ? static_cast<float>(sumAgeUs) / static_cast<float>(count) : 0.0f;
+    }
+};
+
+// Block render time (parameters, engine and sample conversion; not the
+// wait in the I2S write) from the cycle counter, over a reporting window
+struct DspLoadWindow {
+    uint32_t blocks = 0;
+    uint64_t sumCycles = 0;
+    uint64_t peakCycles = 0;
+
+    void add(uint64_t cycles) {
+        blocks++;
+        sumCycles += cycles;
+        if (cycles > peakCycles) peakCycles = cycles;
+    }
+
+    void clear() {
+        *this = DspLoadWindow();
+    }
+
+    // In percent of cyclesPerBlock
+    float avgPercent(float cyclesPerBlock) const {
+        return blocks ? 100.0f * static_cast<float>(sumCycles) / (static_cast<float>(blocks) * cyclesPerBlock) : 0.0f;
+    }
+
+    float peakPercent(float cyclesPerBlock) const {
+        return 100.0f * static_cast<float>(peakCycles) / cyclesPerBlock;
+    }
+};
 
 class DspTask {
 public:
+    DspTask()
+        : pitchCv_(0.5f)
+        , lastBlockStart_(0)
+        , blockCount_(0)
+        , paramGeneration_(0)
+        , gateLevel_(false)
+        , droppedSeen_(0)
+        , cyclesPerBlock_(1.0f)
+        , deadlineMisses_(0)
+    {
+    }
+
     void init() {
+        // Polyphony is capped to what fits in this share of a block period
+        // (before audio starts: the host measures its counter rate here)
+        double blockSeconds = static_cast<double>(AUDIO_BLOCK_SIZE) / SAMPLE_RATE;
+        cyclesPerBlock_ = static_cast<float>(static_cast<double>(platform::cycleRate()) * blockSeconds);
+        engine_.setCycleBudget(static_cast<platform::CycleCount>(cyclesPerBlock_ * POLY_CPU_BUDGET));
+
         if (!audioOut_.init()) {
-            Serial.println("Audio init failed!");
+            platform::log("Audio init failed!\n");
         }
         gate_.init();
     }
 
     void run() {
-        ParamMessage params{};
-        params.pot0 = 0.5f;
-        params.pot1 = 0.5f;
-        params.pot2 = 0.5f;
-        params.cv0 = 0.5f;
-        params.cv1 = 0.5f;
-        params.cv2 = 0.5f;
-        params.voice = static_cast<uint8_t>(VoiceType::CASCADE);
-        params.attack = 0.1f;
-        params.decay = 0.5f;
-        params.wavefold = 0.0f;
-        params.chaos = 0.0f;
-        params.fmFeedback = 0.2f;
-        params.fmFold = 0.0f;
-        params.verbMix = 0.6f;
-        params.verbExcite = 0.5f;
-        params.cvPitchOffset = 0.0f;
-        params.cvPitchScale = 1.0f;
-
-        // Audio buffer (stereo interleaved)
-        uint16_t audioBuffer[AUDIO_BLOCK_SIZE * 2];
+        ParamMessage params = makeDefaultParams();
 
         unsigned long lastStatusTime = 0;
         unsigned long lastDebugTime = 0;
 
-        while (true) {
-            // Read latest parameters
-            while (xQueueReceive(gParamQueue, &params, 0) == pdTRUE) {
-            }
+        engine_.applyParams(params);
+        gateLevel_ = gate_.readGateIn();
+        droppedSeen_ = gate_.getDroppedEdges();
+        engine_.setGateInput(gateLevel_);
 
-            // Update envelope parameters
-            engine_.setAttack(params.attack);
-            engine_.setDecay(params.decay);
-            VoiceType voice = static_cast<VoiceType>(params.voice);
-            engine_.setVoice(voice);
-
-            engine_.setWavefold(params.wavefold);
-            engine_.setChaos(params.chaos);
-            engine_.setFmFeedback(params.fmFeedback);
-            engine_.setFmFold(params.fmFold);
-            engine_.setVerbMix(params.verbMix);
-            engine_.setVerbExcite(params.verbExcite);
-
-            // DIRECT MAPPING - no smoothing, pot is the value
-            // Pot0/Pot1 = voice-specific timbre controls
-            // Pot2 = Pitch (0-1)
-            // Only pitch CV is active.
-
-            float spread = params.pot0;
-            float cascade = params.pot1;
-            float fmIndex = params.pot0;
-            float fmRatio = params.pot1;
-            float verbFeedback = params.pot0;
-            float verbDamp = params.pot1;
-
-            if (voice == VoiceType::CASCADE) {
-                engine_.setHarmonicSpread(clamp(spread, 0.0f, 1.0f));
-                engine_.setCascadeRate(clamp(cascade, 0.0f, 1.0f));
-            } else if (voice == VoiceType::ORBIT_FM) {
-                engine_.setFmIndex(clamp(fmIndex, 0.0f, 1.0f));
-                engine_.setFmRatio(clamp(fmRatio, 0.0f, 1.0f));
-            } else {
-                engine_.setVerbFeedback(clamp(verbFeedback, 0.0f, 1.0f));
-                engine_.setVerbDamp(clamp(verbDamp, 0.0f, 1.0f));
-            }
+        while (platform::keepRunning()) {
+            uint32_t blockStart = platform::micros();
+            platform::CycleCount renderStart = platform::cycleCount();
+            trackBlockStart(blockStart);
 
-            constexpr float kPitchOctaves = 5.0f;
-            // Apply CV offset and scale (hardware CV inversion handled by pitch inversion below)
-            float cvPitch = (params.cv2 - 0.5f) * params.cvPitchScale + params.cvPitchOffset;
-            float pitch = params.pot2 + cvPitch;
-            pitch = clamp(pitch, 0.0f, 1.0f);
-            pitch = 1.0f - pitch;
-            float freq = MIN_FREQ * powf(2.0f, pitch * kPitchOctaves);
-            engine_.setFrequency(freq);
+            // Latest parameters, applied only when the UI published new
+            // ones; pitch CV comes straight from the ADC stream every block
+            float pitchCv[kMaxCvSamples];
+            int cvCount = readPitchCv(pitchCv);
+            if (gParamBuffer.read(params)) {
+                // Only what changed since the last snapshot; if snapshots
+                // were skipped their changes are unknown, so apply all
+                uint32_t generation = gParamBuffer.getReadGeneration();
+                ParamMask changed = generation == paramGeneration_ + 1 ? params.dirty : kAllParams;
+                paramGeneration_ = generation;
+                params.cv2 = pitchCv_;
+                engine_.applyParams(params, changed);
+            }
+            if (cvCount > 0) {
+                engine_.setPitchCv(pitchCv, cvCount);
+            }
+            VoiceType voice = engine_.getVoice();
 
-            // Drone mode when decay > 98%
-            bool droneMode = (params.decay > 0.98f);
-            engine_.gate(params.gateIn || droneMode);
+            // Generate audio block, split at gate edges
+            NoteEvent events[kMaxBlockEvents];
+            int eventCount = collectGateEvents(blockStart, events);
+            engine_.processBlock(block_, AUDIO_BLOCK_SIZE, events, eventCount);
 
-            // Generate audio block
             float verbPeak = 0.0f;
             for (int i = 0; i < AUDIO_BLOCK_SIZE; ++i) {
-                float sample = engine_.process();
-                if (voice == VoiceType::PITCH_VERB) {
-                    float absSample = fabsf(sample);
-                    if (absSample > verbPeak) {
-                        verbPeak = absSample;
-                    }
+                float absSample = fabsf(block_[i]);
+                if (absSample > verbPeak) {
+                    verbPeak = absSample;
                 }
-                uint16_t dacSample = AudioOutput::floatToSample(sample);
-                audioBuffer[i * 2] = dacSample;
-                audioBuffer[i * 2 + 1] = dacSample;
+                uint16_t dacSample = AudioOutput::floatToSample(block_[i]);
+                audioBuffer_[i * 2] = dacSample;
+                audioBuffer_[i * 2 + 1] = dacSample;
             }
 
+            trackLoad(platform::cycleCount() - renderStart);
+
             // Write buffer to I2S
             size_t bytesWritten = 0;
-            audioOut_.write(audioBuffer, sizeof(audioBuffer), &bytesWritten);
+            audioOut_.write(audioBuffer_, sizeof(audioBuffer_), &bytesWritten);
 
             // Update gate output
             gate_.setGateOut(engine_.isPlaying());
 
             // Debug output every 1 second
-            unsigned long now = millis();
+            unsigned long now = platform::millis();
             if (now - lastDebugTime > 1000) {
-                const char* voiceName = (voice == VoiceType::CASCADE) ? "CASCADE" : (voice == VoiceType::ORBIT_FM ? "ORBIT" : "VERB");
-                Serial.printf("VOICE:%s GATE:%d POT0:%.2f POT1:%.2f POT2:%.2f | Freq:%.0f Env:%.2f\n",
-                    voiceName, params.gateIn ? 1 : 0, params.pot0, params.pot1, params.pot2, freq, engine_.getEnvelopeLevel());
+                const char* voiceName = ClaudiusVoices::info(ClaudiusVoices::indexOf(voice)).tag;
+                platform::log("VOICE:%s GATE:%d POT0:%.2f POT1:%.2f POT2:%.2f | Freq:%.0f Env:%.2f\n",
+                    voiceName, gate_.readGateIn() ? 1 : 0, params.pot0, params.pot1, params.pot2, engine_.getFrequency(), engine_.getEnvelopeLevel());
                 if (voice == VoiceType::PITCH_VERB) {
-                    int c0 = 0, c1 = 0, c2 = 0, c3 = 0, ap0 = 0, ap1 = 0;
-                    engine_.getVerbDelayStats(c0, c1, c2, c3, ap0, ap1);
-                    Serial.printf("VERB fb:%.2f damp:%.2f mix:%.2f excite:%.2f | base:%.1f comb:%d/%d/%d/%d ap:%d/%d\n",
-                        params.pot0, params.pot1, params.verbMix, params.verbExcite,
-                        engine_.getVerbBaseFreq(), c0, c1, c2, c3, ap0, ap1);
-                    Serial.printf("VERB peak:%.4f\n", verbPeak);
+                    engine_.getVoices().ifPresent<PitchedVerb>([&](const PitchedVerb& verb) {
+                        int c0 = 0, c1 = 0, c2 = 0, c3 = 0, ap0 = 0, ap1 = 0;
+                        verb.getDelayStats(c0, c1, c2, c3, ap0, ap1);
+                        platform::log("VERB fb:%.2f damp:%.2f mix:%.2f excite:%.2f | base:%.1f comb:%d/%d/%d/%d ap:%d/%d\n",
+                            params.pot0, params.pot1, params.verbMix, params.verbExcite,
+                            verb.getBaseFreq(), c0, c1, c2, c3, ap0, ap1);
+                        platform::log("VERB peak:%.4f\n", verbPeak);
+                    });
                 }
+                const VoiceArena& arena = engine_.getArena();
+                platform::log("ARENA used:%u peak:%u of %u bytes\n",
+                    static_cast<unsigned>(arena.getUsed()),
+                    static_cast<unsigned>(arena.getPeak()),
+                    static_cast<unsigned>(arena.getCapacity()));
+                platform::log("POLY notes:%d limit:%d/%d cost:%.0f cycles/note-block | block:%u peak:%u cycles\n",
+                    engine_.getSoundingVoices(), engine_.getPolyphonyLimit(), POLYPHONY,
+                    engine_.getVoiceCycles(),
+                    static_cast<unsigned>(engine_.getBlockCycles()),
+                    static_cast<unsigned>(engine_.getPeakBlockCycles()));
+                platform::log("GATE edges:%u late:%u dropped:%u resynced:%u | age avg:%.0f max:%u us | jitter:%u us\n",
+                    static_cast<unsigned>(gateStats_.count), static_cast<unsigned>(gateStats_.late),
+                    static_cast<unsigned>(gate_.getDroppedEdges()), static_cast<unsigned>(gateStats_.resynced),
+                    gateStats_.avgAgeUs(),
+                    static_cast<unsigned>(gateStats_.maxAgeUs), static_cast<unsigned>(gateStats_.maxJitterUs));
+                platform::log("ADC pitch cv:%.3f dropped:%u\n", pitchCv_, static_cast<unsigned>(gAdc.getDropped()));
+                logLoad();
                 lastDebugTime = now;
             }
 
@@ -148,14 +191,170 @@ public:
                 status.outputLevel = engine_.getOutputLevel();
                 status.isPlaying = engine_.isPlaying();
                 status.currentFreq = engine_.getFrequency();
-                xQueueOverwrite(gStatusQueue, &status);
+                fillLoadStatus(status);
+                gStatusQueue.overwrite(status);
                 lastStatusTime = now;
             }
         }
     }
 
+    const ClaudiusEngine& getEngine() const {
+        return engine_;
+    }
+
+    const GateEventStats& getGateStats() const {
+        return gateStats_;
+    }
+
+    uint32_t getDroppedGateEdges() const {
+        return gate_.getDroppedEdges();
+    }
+
+    // Since start
+    const DspLoadWindow& getLoad() const {
+        return totalLoad_;
+    }
+
+    float getCyclesPerBlock() const {
+        return cyclesPerBlock_;
+    }
+
+    uint32_t getDeadlineMisses() const {
+        return deadlineMisses_;
+    }
+
 private:
+    static constexpr int kMaxBlockEvents = 8;
+    static constexpr int kMaxCvSamples = 8;  // ~1.5 arrive per block, in pairs
+    static constexpr uint32_t kBlockUs = static_cast<uint32_t>(1.0e6f * AUDIO_BLOCK_SIZE / SAMPLE_RATE + 0.5f);
+    // Blocks go out back to back until the I2S DMA queue (8 blocks) fills,
+    // so block spacing only means something after that
+    static constexpr uint32_t kSteadyBlocks = 16;
+
+    // Take the gate edges that happened before blockStart and give each
+    // the offset it had in the block period that ended there, so all land
+    // exactly one block period late. Edges older than that (the DSP fell
+    // behind) go at offset 0; newer ones wait for the next block.
+    // Edges dropped by a full queue would leave the gate wrong (a lost
+    // falling edge holds the note), so once the queue has drained after a
+    // drop the pin level is compared and a missing edge made up.
+    int collectGateEvents(uint32_t blockStart, NoteEvent* events) {
+        int count = 0;
+        GateEdge edge;
+        while (count < kMaxBlockEvents && gate_.peekEdge(edge)) {
+            int32_t age = static_cast<int32_t>(blockStart - edge.micros);
+            if (age < 0) break;
+            gate_.popEdge();
+            gateLevel_ = edge.high;
+
+            int offset = AUDIO_BLOCK_SIZE - static_cast<int>(static_cast<float>(age) * SAMPLE_RATE * 1.0e-6f + 0.5f);
+            if (offset < 0) {
+                offset = 0;
+                gateStats_.late++;
+            }
+            NoteEvent::Type type = edge.high ? NoteEvent::Type::GATE_ON : NoteEvent::Type::GATE_OFF;
+            events[count++] = NoteEvent{type, offset, 0.0f};
+
+            gateStats_.count++;
+            gateStats_.sumAgeUs += static_cast<uint32_t>(age);
+            if (static_cast<uint32_t>(age) > gateStats_.maxAgeUs) gateStats_.maxAgeUs = static_cast<uint32_t>(age);
+        }
+
+        uint32_t dropped = gate_.getDroppedEdges();
+        if (dropped != droppedSeen_ && count < kMaxBlockEvents && !gate_.peekEdge(edge)) {
+            droppedSeen_ = dropped;
+            bool high = gate_.readGateIn();
+            if (high != gateLevel_) {
+                gateLevel_ = high;
+                // After this block's edges, which all came before the level
+                // read; at the block start when there are none
+                NoteEvent::Type type = high ? NoteEvent::Type::GATE_ON : NoteEvent::Type::GATE_OFF;
+                int offset = count > 0 ? events[count - 1].offset : 0;
+                events[count++] = NoteEvent{type, offset, 0.0f};
+                gateStats_.resynced++;
+            }
+        }
+        return count;
+    }
+
+    // Filtered pitch CV samples since the last block into cv, oldest first;
+    // the decimator has already averaged the conversions behind them
+    int readPitchCv(float* cv) {
+        uint16_t samples[kMaxCvSamples];
+        int count = gAdc.readPitchCv(samples, kMaxCvSamples);
+        for (int i = 0; i < count; ++i) {
+            cv[i] = normalizeAdc(samples[i], CAL_CV2);
+        }
+        if (count > 0) pitchCv_ = cv[count - 1];
+        return count;
+    }
+
+    void trackLoad(uint64_t cycles) {
+        statusLoad_.add(cycles);
+        logLoad_.add(cycles);
+        totalLoad_.add(cycles);
+        if (static_cast<float>(cycles) > cyclesPerBlock_) deadlineMisses_++;
+    }
+
+    // Load since the last status message
+    void fillLoadStatus(StatusMessage& status) {
+        status.loadAvg = statusLoad_.avgPercent(cyclesPerBlock_);
+        status.loadPeak = statusLoad_.peakPercent(cyclesPerBlock_);
+        statusLoad_.clear();
+        for (float& load : status.voiceLoad) {
+            load = 0.0f;
+        }
+        for (int i = 0; i < ClaudiusVoices::kCount; ++i) {
+            int type = static_cast<int>(ClaudiusVoices::info(i).type);
+            status.voiceLoad[type] = 100.0f * engine_.getVoiceCycles(i) / cyclesPerBlock_;
+        }
+        status.notes = static_cast<uint8_t>(engine_.getSoundingVoices());
+        status.polyLimit = static_cast<uint8_t>(engine_.getPolyphonyLimit());
+        status.deadlineMisses = deadlineMisses_;
+        status.underruns = audioOut_.getUnderruns();
+    }
+
+    // Load since the last log line, then each voice's cost per note
+    void logLoad() {
+        char voices[64] = "";
+        int length = 0;
+        for (int i = 0; i < ClaudiusVoices::kCount && length < static_cast<int>(sizeof(voices)); ++i) {
+            length += snprintf(voices + length, sizeof(voices) - length, " %s:%.1f%%",
+                ClaudiusVoices::info(i).tag, 100.0f * engine_.getVoiceCycles(i) / cyclesPerBlock_);
+        }
+        platform::log("LOAD avg:%.1f%% peak:%.1f%% | late blocks:%u underruns:%u | note%s\n",
+            logLoad_.avgPercent(cyclesPerBlock_), logLoad_.peakPercent(cyclesPerBlock_),
+            static_cast<unsigned>(deadlineMisses_), static_cast<unsigned>(audioOut_.getUnderruns()), voices);
+        logLoad_.clear();
+    }
+
+    void trackBlockStart(uint32_t blockStart) {
+        if (blockCount_ >= kSteadyBlocks) {
+            uint32_t spacing = blockStart - lastBlockStart_;
+            uint32_t jitter = spacing > kBlockUs ? spacing - kBlockUs : kBlockUs - spacing;
+            if (jitter > gateStats_.maxJitterUs) gateStats_.maxJitterUs = jitter;
+        }
+        lastBlockStart_ = blockStart;
+        blockCount_++;
+    }
+
     ClaudiusEngine engine_;
     AudioOutput audioOut_;
     Gate gate_;
+    GateEventStats gateStats_;
+    float pitchCv_;
+    uint32_t lastBlockStart_;
+    uint32_t blockCount_;
+    uint32_t paramGeneration_;  // Of the last parameter snapshot applied
+    bool gateLevel_;            // After the last gate event passed to the engine
+    uint32_t droppedSeen_;      // Dropped edges already resynced
+    float cyclesPerBlock_;      // Counter cycles in one block period
+    DspLoadWindow statusLoad_;
+    DspLoadWindow logLoad_;
+    DspLoadWindow totalLoad_;
+    uint32_t deadlineMisses_;
+
+    // The block being rendered, and as DAC samples (stereo interleaved)
+    float block_[AUDIO_BLOCK_SIZE];
+    uint16_t audioBuffer_[AUDIO_BLOCK_SIZE * 2];
 };
@@ -1,11 +1,28 @@
 #pragma once
 
 #include <cmath>
-#include <algorithm>
+#include <cstdint>
 #include "Config.h"
 #include "Calibration.h"
+#include "Parameters.h"
+#include "Utils.h"
 
-// Attack-Decay envelope for the voice module
+// Attack-Decay-Sustain-Release envelope for the voice module
+//
+// At full sustain there is nothing to decay to while the gate is held, so
+// the envelope is the original attack-decay: Decay sets the fade after the
+// gate falls and Release is not used. Below full sustain Decay runs down to
+// the sustain level and Release takes over at the gate's falling edge.
+//
+// Every stage is a segment with a known length in samples. A segment is
+// filled with the affine recurrence level = level * mult + add, which
+// covers all curve shapes in closed form:
+//   LINEAR  mult = 1, a constant step
+//   EXP     mult < 1, geometric approach to a target just past the end
+//           (fast start, slow finish, like an RC)
+//   LOG     mult > 1, the mirror image (slow start, fast finish)
+// Each block fills min(remaining, block) samples per segment, so a stage
+// change lands on the exact sample and the end level is hit exactly.
 
 class Envelope {
 public:
@@ -13,42 +30,83 @@ public:
         IDLE,
         ATTACK,
         DECAY,
-        SUSTAIN
+        SUSTAIN,
+        RELEASE
     };
 
     explicit Envelope(float sampleRate = SAMPLE_RATE)
         : sampleRate_(sampleRate)
         , stage_(Stage::IDLE)
         , level_(0.0f)
-        , attackRate_(0.01f)
-        , decayRate_(0.001f)
+        , mult_(1.0f)
+        , add_(0.0f)
+        , target_(0.0f)
+        , remaining_(0)
+        , attackTime_(0.01f)
+        , decayTime_(0.5f)
+        , releaseTime_(0.5f)
+        , sustain_(1.0f)
+        , curve_(EnvelopeCurve::EXP)
+        , attack_(-1.0f)
+        , decay_(-1.0f)
+        , release_(-1.0f)
     {
     }
 
+    // Controls arrive every block; the exp mapping only runs when the
+    // value actually moved. New times take effect at the next segment.
     void setAttack(float normalizedAttack) {
+        if (!assignIfChanged(attack_, normalizedAttack)) return;
         // Map normalized 0-1 to attack time in seconds
-        float attackTime = expMap(normalizedAttack, MIN_ATTACK, MAX_ATTACK);
-        attackRate_ = 1.0f / (attackTime * sampleRate_);
+        attackTime_ = expMap(normalizedAttack, MIN_ATTACK, MAX_ATTACK);
     }
 
     void setDecay(float normalizedDecay) {
-        // Map normalized 0-1 to decay time in seconds
-        float decayTime = expMap(normalizedDecay, MIN_DECAY, MAX_DECAY);
-        // Use exponential decay coefficient
-        // We want to reach ~0.001 (-60dB) in decayTime seconds
-        decayCoeff_ = powf(0.001f, 1.0f / (decayTime * sampleRate_));
+        if (!assignIfChanged(decay_, normalizedDecay)) return;
+        // Map normalized 0-1 to decay time in seconds (full scale to sustain)
+        decayTime_ = expMap(normalizedDecay, MIN_DECAY, MAX_DECAY);
+    }
+
+    void setRelease(float normalizedRelease) {
+        if (!assignIfChanged(release_, normalizedRelease)) return;
+        // Map normalized 0-1 to release time in seconds (full scale to zero)
+        releaseTime_ = expMap(normalizedRelease, MIN_DECAY, MAX_DECAY);
+    }
+
+    void setSustain(float level) {
+        sustain_ = clamp(level, 0.0f, 1.0f);
+    }
+
+    void setCurve(EnvelopeCurve curve) {
+        curve_ = curve;
     }
 
     void trigger() {
-        stage_ = Stage::ATTACK;
+        // Attack from the current level, so retriggers do not click
+        startSegment(Stage::ATTACK, 1.0f, attackTime_, kAttackCurveRatio);
     }
 
     void release() {
         if (stage_ != Stage::IDLE) {
-            stage_ = Stage::DECAY;
+            startSegment(Stage::RELEASE, 0.0f, sustain_ < 1.0f ? releaseTime_ : decayTime_, kDecayCurveRatio);
         }
     }
 
+    // Release over `seconds` for a full-scale level, whatever the release
+    // setting (voice stealing)
+    void fadeOut(float seconds) {
+        if (stage_ != Stage::IDLE) {
+            startSegment(Stage::RELEASE, 0.0f, seconds, kDecayCurveRatio);
+        }
+    }
+
+    // Silence immediately
+    void reset() {
+        stage_ = Stage::IDLE;
+        level_ = 0.0f;
+        remaining_ = 0;
+    }
+
     void gate(bool on) {
         if (on) {
             trigger();
@@ -58,34 +116,45 @@ public:
     }
 
     float process() {
-        switch (stage_) {
-            case Stage::IDLE:
-                level_ = 0.0f;
-                break;
+        float level;
+        processBlock(&level, 1);
+        return level;
+    }
 
-            case Stage::ATTACK:
-                level_ += attackRate_;
-                if (level_ >= 1.0f) {
-                    level_ = 1.0f;
-                    stage_ = Stage::SUSTAIN;
+    // Render numSamples of envelope, one closed-form fill per segment
+    void processBlock(float* out, int numSamples) {
+        int i = 0;
+        while (i < numSamples) {
+            if (stage_ == Stage::IDLE || stage_ == Stage::SUSTAIN) {
+                // Hold; a moved sustain level is followed directly
+                if (stage_ == Stage::SUSTAIN) level_ = sustain_;
+                for (; i < numSamples; ++i) {
+                    out[i] = level_;
                 }
                 break;
+            }
 
-            case Stage::SUSTAIN:
-                // Hold at maximum while gate is held
-                level_ = 1.0f;
-                break;
+            int count = numSamples - i;
+            if (remaining_ < count) count = remaining_;
 
-            case Stage::DECAY:
-                level_ *= decayCoeff_;
-                if (level_ < 0.001f) {
-                    level_ = 0.0f;
-                    stage_ = Stage::IDLE;
-                }
-                break;
-        }
+            float level = level_;
+            const float mult = mult_;
+            const float add = add_;
+            for (int n = 0; n < count; ++n) {
+                level = level * mult + add;
+                out[i + n] = level;
+            }
+            level_ = level;
+            i += count;
+            remaining_ -= count;
 
-        return level_;
+            if (remaining_ == 0) {
+                // Land exactly on the segment's end level
+                level_ = target_;
+                if (i > 0) out[i - 1] = level_;
+                finishSegment();
+            }
+        }
     }
 
     bool isActive() const {
@@ -101,10 +170,88 @@ public:
     }
 
 private:
+    // Distance left to the asymptote when an EXP/LOG segment ends: attacks
+    // are gently curved, decays and releases follow -60 dB like an RC
+    static constexpr float kAttackCurveRatio = 0.3f;
+    static constexpr float kDecayCurveRatio = 0.001f;
+
+    // Plan a segment from the current level to `target`. fullTime is the
+    // time for a full-scale move; shorter moves take proportionally less.
+    void startSegment(Stage stage, float target, float fullTime, float curveRatio) {
+        stage_ = stage;
+        target_ = target;
+
+        float span = (stage == Stage::DECAY) ? 1.0f - sustain_ : 1.0f;
+        float distance = fabsf(target - level_);
+        float fraction = (span > 0.0f) ? distance / span : 0.0f;
+        int length = static_cast<int>(fullTime * sampleRate_ * fraction + 0.5f);
+
+        if (length < 1 || distance <= 0.0f) {
+            remaining_ = 1;
+            mult_ = 0.0f;
+            add_ = target;
+            return;
+        }
+        remaining_ = length;
+
+        if (curve_ == EnvelopeCurve::LINEAR) {
+            mult_ = 1.0f;
+            add_ = (target - level_) / static_cast<float>(length);
+            return;
+        }
+
+        // Geometric segment level(n) = pivot + (start - pivot) * mult^n with
+        // level(length) == target. EXP shrinks the distance to a pivot just
+        // past the target; LOG grows the distance from a pivot just behind
+        // the start.
+        float start = level_;
+        float pivot;
+        if (curve_ == EnvelopeCurve::EXP) {
+            mult_ = powf(curveRatio, 1.0f / static_cast<float>(length));
+            pivot = (target - start * curveRatio) / (1.0f - curveRatio);
+        } else {
+            mult_ = powf(curveRatio, -1.0f / static_cast<float>(length));
+            pivot = (target * curveRatio - start) / (curveRatio - 1.0f);
+        }
+        add_ = pivot * (1.0f - mult_);
+    }
+
+    void finishSegment() {
+        switch (stage_) {
+            case Stage::ATTACK:
+                startSegment(Stage::DECAY, sustain_, decayTime_, kDecayCurveRatio);
+                break;
+            case Stage::DECAY:
+                stage_ = Stage::SUSTAIN;
+                break;
+            case Stage::RELEASE:
+                level_ = 0.0f;
+                stage_ = Stage::IDLE;
+                break;
+            default:
+                break;
+        }
+    }
+
     float sampleRate_;
     Stage stage_;
     float level_;
-    float attackRate_;
-    float decayRate_;
-    float decayCoeff_;
+
+    // Current segment
+    float mult_;
+    float add_;
+    float target_;
+    int remaining_;
+
+    // Times in seconds for a full-scale move
+    float attackTime_;
+    float decayTime_;
+    float releaseTime_;
+    float sustain_;
+    EnvelopeCurve curve_;
+
+    // Last normalized controls, for change detection
+    float attack_;
+    float decay_;
+    float release_;
 };
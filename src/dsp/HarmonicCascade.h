@@ -3,139 +3,238 @@
 #include <cmath>
 #include "Config.h"
 #include "Utils.h"
+#include "OscillatorCore.h"
+#include "PartialBank.h"
 
 // Claudius: Additive Synthesizer with Harmonic Cascade
 //
-// SPREAD: Controls how many harmonics are active (1-8)
-// CASCADE: Controls relative amplitude of higher harmonics
+// SPREAD: Controls how many harmonics are active (1-MAX_HARMONICS)
+// CASCADE: How much faster each higher harmonic decays. Every partial starts
+//          at full level on trigger and decays on its own envelope; the
+//          fundamental holds, harmonic n decays (n - 1) times as fast as
+//          the 2nd. At 0 the spectrum is static.
 // WAVEFOLD: Adds distortion/harmonics
 // CHAOS: Lorenz attractor modulation of harmonic amplitudes
+//
+// Controls are staged by the setters and committed into per-harmonic
+// coefficients by prepare(), only when something changed. Wavefold can
+// also be given per sample while it glides.
 
 class HarmonicCascade {
 public:
     explicit HarmonicCascade(float sampleRate = SAMPLE_RATE)
         : sampleRate_(sampleRate)
         , baseFreq_(220.0f)
+        , spread_(0.5f)
+        , cascade_(0.5f)
+        , wavefold_(0.0f)
+        , chaos_(0.0f)
+        , dirty_(true)
     {
         reset();
+        prepare();
     }
 
     void reset() {
-        for (int i = 0; i < MAX_HARMONICS; ++i) {
-            phases_[i] = 0.0f;
-        }
+        bank_.reset();
         lorenzX_ = 0.1f;
         lorenzY_ = 0.0f;
         lorenzZ_ = 0.0f;
     }
 
     void setFrequency(float freq) {
-        baseFreq_ = clamp(freq, MIN_FREQ, MAX_FREQ);
+        dirty_ |= assignIfChanged(baseFreq_, clamp(freq, MIN_FREQ, MAX_FREQ));
     }
 
-    void trigger() {
-        // Reset phases for clean attack
-        for (int i = 0; i < MAX_HARMONICS; ++i) {
-            phases_[i] = 0.0f;
-        }
+    void setSpread(float normalized) {
+        dirty_ |= assignIfChanged(spread_, clamp(normalized, 0.0f, 1.0f));
     }
 
-    float process(float spread, float cascade, float wavefold, float chaos, float envelope) {
-        // Lorenz attractor for chaotic modulation
-        constexpr float kSigma = 10.0f;
-        constexpr float kRho = 28.0f;
-        constexpr float kBeta = 8.0f / 3.0f;
-        float dt = 1.0f / sampleRate_;
-        float dx = kSigma * (lorenzY_ - lorenzX_);
-        float dy = lorenzX_ * (kRho - lorenzZ_) - lorenzY_;
-        float dz = lorenzX_ * lorenzY_ - kBeta * lorenzZ_;
-        lorenzX_ += dx * dt;
-        lorenzY_ += dy * dt;
-        lorenzZ_ += dz * dt;
+    void setCascade(float normalized) {
+        dirty_ |= assignIfChanged(cascade_, clamp(normalized, 0.0f, 1.0f));
+    }
 
-        // Map chaotic state to a smooth 0-1 modulator
-        float chaosNorm = 0.5f + 0.5f * fastTanh(lorenzX_ * 0.08f + lorenzY_ * 0.03f);
+    void setWavefold(float normalized) {
+        dirty_ |= assignIfChanged(wavefold_, clamp(normalized, 0.0f, 1.0f));
+    }
 
-        float output = 0.0f;
-        float totalAmp = 0.0f;
+    void setChaos(float normalized) {
+        dirty_ |= assignIfChanged(chaos_, clamp(normalized, 0.0f, 1.0f));
+    }
 
-        // SPREAD determines how many harmonics (1 to 8)
-        // At spread=0, only fundamental
-        // At spread=1, all 8 harmonics
-        int numHarmonics = 1 + static_cast<int>(spread * 7.0f);
-
-        for (int i = 0; i < numHarmonics; ++i) {
-            int harmonic = i + 1;  // 1, 2, 3, 4, 5, 6, 7, 8
-
-            // CASCADE determines amplitude rolloff
-            // cascade=0: all harmonics equal amplitude
-            // cascade=1: 1/n rolloff (like sawtooth)
-            float ampRolloff;
-            if (cascade < 0.01f) {
-                // No rolloff - all harmonics equal
-                ampRolloff = 1.0f;
-            } else {
-                // Interpolate between equal (1.0) and 1/n
-                float equalAmp = 1.0f;
-                float sawAmp = 1.0f / static_cast<float>(harmonic);
-                ampRolloff = equalAmp * (1.0f - cascade) + sawAmp * cascade;
-            }
+    void trigger() {
+        // Reset phases for clean attack, all partials back to full level
+        bank_.reset();
+    }
 
+    // Commit staged controls: which harmonics sound, their decay, chaos
+    // depth and per-sample rotation
+    void prepare() {
+        if (!dirty_) return;
+        dirty_ = false;
+
+        // SPREAD determines how many harmonics (1 to MAX_HARMONICS)
+        // At spread=0, only fundamental
+        // At spread=1, all harmonics
+        int numHarmonics = 1 + static_cast<int>(spread_ * static_cast<float>(MAX_HARMONICS - 1));
+
+        // Anti-aliasing: harmonic n sounds only while n * freq <= 0.45 * sampleRate
+        int belowNyquist = static_cast<int>(sampleRate_ * 0.45f / baseFreq_);
+        int active = numHarmonics < belowNyquist ? numHarmonics : belowNyquist;
+
+        // Fundamental rotation from the shared sine table, higher harmonics
+        // by repeated complex multiplication
+        Phase inc = phaseIncrement(baseFreq_, sampleRate_);
+        float c1 = sineLookup(inc + 0x40000000u);
+        float s1 = sineLookup(inc);
+        normalizePair(c1, s1);
+        float c = c1;
+        float s = s1;
+
+        // CASCADE sets the 2nd harmonic's -60 dB time to
+        // CASCADE_DECAY_TIME / cascade; harmonic n's per-sample coefficient
+        // is that one raised to (n - 1)
+        float step = (cascade_ > 0.0f)
+            ? powf(0.001f, cascade_ / (CASCADE_DECAY_TIME * sampleRate_))
+            : 1.0f;
+        float decay = 1.0f;
+
+        for (int i = 0; i < active; ++i) {
             float chaosWeight = (numHarmonics > 1)
                 ? static_cast<float>(i) / static_cast<float>(numHarmonics - 1)
                 : 1.0f;
-            float chaosMod = 1.0f + chaos * chaosWeight * (chaosNorm - 0.5f) * 1.8f;
-            if (chaosMod < 0.15f) chaosMod = 0.15f;
-            ampRolloff *= chaosMod;
 
-            // Calculate frequency
-            float freq = baseFreq_ * static_cast<float>(harmonic);
+            bank_.setPartial(i, c, s, 1.0f, chaos_ * chaosWeight, decay);
+            decay *= step;
 
-            // Anti-aliasing: skip harmonics above Nyquist
-            if (freq > sampleRate_ * 0.45f) continue;
+            float nextC = c * c1 - s * s1;
+            s = c * s1 + s * c1;
+            c = nextC;
+            normalizePair(c, s);
+        }
+        bank_.setActive(active);
 
-            // Phase increment
-            float phaseInc = freq / sampleRate_;
-            phases_[i] += phaseInc;
-            if (phases_[i] >= 1.0f) phases_[i] -= 1.0f;
+        chaotic_ = chaos_ != 0.0f;
+        folding_ = wavefold_ > 0.01f;
+        drive_ = 1.0f + wavefold_ * 4.0f;
+        dt_ = 1.0f / sampleRate_;
+    }
 
-            // Generate sine
-            float sample = sinf(phases_[i] * 2.0f * M_PI);
+    int getActivePartials() const {
+        return bank_.getActive();
+    }
 
-            // Accumulate
-            output += sample * ampRolloff;
-            totalAmp += ampRolloff;
+    float process(float envelope) {
+        float out;
+        processBlock(&out, &envelope, 1);
+        return out;
+    }
+
+    // Per-sample wavefold (0-1) is optional; without it the staged value
+    // holds for the block
+    void processBlock(float* out, const float* envelope, int numSamples, const float* wavefold = nullptr) {
+        prepare();
+
+        if (chaotic_) {
+            for (int n = 0; n < numSamples; ++n) {
+                chaosMod_[n] = stepLorenz();
+            }
+            bank_.render<true>(sum_, totalAmp_, chaosMod_, numSamples);
+        } else {
+            for (int n = 0; n < numSamples; ++n) {
+                stepLorenz();
+            }
+            bank_.render<false>(sum_, totalAmp_, nullptr, numSamples);
         }
+        bank_.finishBlock();
 
-        // Normalize to prevent clipping
-        if (totalAmp > 1.0f) {
-            output /= totalAmp;
+        if (wavefold) {
+            shapeBlock<true>(out, sum_, totalAmp_, envelope, wavefold, numSamples);
+        } else {
+            shapeBlock<false>(out, sum_, totalAmp_, envelope, nullptr, numSamples);
         }
+    }
+
+private:
+    // Normalize, fold, apply the envelope and soft clip
+    template<bool kRamped>
+    void shapeBlock(float* out, const float* sum, const float* totalAmp, const float* envelope,
+                    const float* wavefold, int numSamples) {
+        for (int n = 0; n < numSamples; ++n) {
+            float output = sum[n];
+
+            // Normalize to prevent clipping
+            if (totalAmp[n] > 1.0f) {
+                output /= totalAmp[n];
+            }
 
-        // Wavefold for extra harmonics/distortion
-        if (wavefold > 0.01f) {
-            float drive = 1.0f + wavefold * 4.0f;
-            float folded = output * drive;
-            // Fold back
-            while (folded > 1.0f || folded < -1.0f) {
-                if (folded > 1.0f) folded = 2.0f - folded;
-                if (folded < -1.0f) folded = -2.0f - folded;
+            // Wavefold for extra harmonics/distortion
+            const float fold = kRamped ? clamp(wavefold[n], 0.0f, 1.0f) : wavefold_;
+            if (kRamped || folding_) {
+                float folded = output * (kRamped ? 1.0f + fold * 4.0f : drive_);
+                // Fold back
+                while (folded > 1.0f || folded < -1.0f) {
+                    if (folded > 1.0f) folded = 2.0f - folded;
+                    if (folded < -1.0f) folded = -2.0f - folded;
+                }
+                output = output * (1.0f - fold) + folded * fold;
             }
-            output = output * (1.0f - wavefold) + folded * wavefold;
+
+            // Apply envelope
+            output *= envelope[n];
+
+            // Soft clip
+            out[n] = fastTanh(output);
         }
+    }
+
+    // Advance the Lorenz attractor one sample and return the chaos
+    // modulator, centred on zero and scaled to +-0.9
+    float stepLorenz() {
+        constexpr float kSigma = 10.0f;
+        constexpr float kRho = 28.0f;
+        constexpr float kBeta = 8.0f / 3.0f;
+
+        float dx = kSigma * (lorenzY_ - lorenzX_);
+        float dy = lorenzX_ * (kRho - lorenzZ_) - lorenzY_;
+        float dz = lorenzX_ * lorenzY_ - kBeta * lorenzZ_;
+        lorenzX_ += dx * dt_;
+        lorenzY_ += dy * dt_;
+        lorenzZ_ += dz * dt_;
 
-        // Apply envelope
-        output *= envelope;
+        // Map chaotic state to a smooth 0-1 modulator
+        float chaosNorm = 0.5f + 0.5f * fastTanh(lorenzX_ * 0.08f + lorenzY_ * 0.03f);
+        return (chaosNorm - 0.5f) * 1.8f;
+    }
 
-        // Soft clip
-        return fastTanh(output);
+    static void normalizePair(float& c, float& s) {
+        float gain = 1.5f - 0.5f * (c * c + s * s);
+        c *= gain;
+        s *= gain;
     }
 
-private:
     float sampleRate_;
     float baseFreq_;
-    float phases_[MAX_HARMONICS];
+    PartialBank bank_;
     float lorenzX_;
     float lorenzY_;
     float lorenzZ_;
+
+    // Staged controls
+    float spread_;
+    float cascade_;
+    float wavefold_;
+    float chaos_;
+    bool dirty_;
+
+    // Committed coefficients
+    bool chaotic_;
+    bool folding_;
+    float drive_;
+    float dt_;
+
+    // Bank output for shapeBlock() and the chaos modulator, per block
+    float sum_[AUDIO_BLOCK_SIZE];
+    float totalAmp_[AUDIO_BLOCK_SIZE];
+    float chaosMod_[AUDIO_BLOCK_SIZE];
 };
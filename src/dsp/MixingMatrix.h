@@ -0,0 +1,42 @@
+#pragma once
+
+// Orthonormal mixing for feedback delay networks.
+//
+// hadamardMix<N>() applies the N x N Hadamard matrix scaled by 1/sqrt(N)
+// in place as log2(N) butterfly stages: N log N adds and N multiplies, no
+// matrix storage. Being orthonormal, it keeps the network lossless, so
+// decay is set entirely by the per-line feedback gains.
+
+namespace mixing_detail {
+
+// 1/sqrt(N) for a power of two N
+constexpr float inverseSqrtPow2(int n) {
+    float scale = 1.0f;
+    while (n >= 4) {
+        scale *= 0.5f;
+        n >>= 2;
+    }
+    return (n == 2) ? scale * 0.70710678f : scale;
+}
+
+}  // namespace mixing_detail
+
+template<int N>
+inline void hadamardMix(float* v) {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "Hadamard size must be a power of two");
+    constexpr float kScale = mixing_detail::inverseSqrtPow2(N);
+
+    for (int half = 1; half < N; half <<= 1) {
+        for (int i = 0; i < N; i += half * 2) {
+            for (int j = i; j < i + half; ++j) {
+                float a = v[j];
+                float b = v[j + half];
+                v[j] = a + b;
+                v[j + half] = a - b;
+            }
+        }
+    }
+    for (int i = 0; i < N; ++i) {
+        v[i] *= kScale;
+    }
+}
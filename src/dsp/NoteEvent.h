@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+// A gate or note change inside the block being rendered, at a sample offset
+// from the block start (0 to numSamples; numSamples applies it after the
+// last sample). ClaudiusEngine::processBlock splits the block at each one.
+struct NoteEvent {
+    enum class Type : uint8_t {
+        GATE_ON,
+        GATE_OFF,
+        NOTE_ON,    // frequency in Hz
+        NOTE_OFF
+    };
+
+    Type type;
+    int offset;
+    float frequency;
+};
@@ -4,72 +4,194 @@
 #include "Config.h"
 #include "Utils.h"
 #include "Calibration.h"
+#include "OscillatorCore.h"
 
 // Orbit FM: 2-operator FM with feedback and folding
 // INDEX: Modulation depth
 // RATIO: Modulator frequency ratio
 // FEEDBACK: Modulator feedback amount
 // FOLD: Post-FM wave folding
+//
+// Controls are staged by the setters; prepare() recomputes the index
+// curve and phase increments only when a control or the pitch moved.
+// processBlock() can also take index, feedback and fold per sample, for
+// controls that are gliding.
 
 class OrbitFm {
 public:
     explicit OrbitFm(float sampleRate = SAMPLE_RATE)
         : sampleRate_(sampleRate)
         , baseFreq_(220.0f)
-        , carrierPhase_(0.0f)
-        , modPhase_(0.0f)
+        , carrierPhase_(0)
+        , modPhase_(0)
         , lastMod_(0.0f)
+        , index_(0.5f)
+        , ratio_(0.5f)
+        , feedback_(0.2f)
+        , fold_(0.0f)
+        , dirty_(true)
     {
+        prepare();
     }
 
     void reset() {
-        carrierPhase_ = 0.0f;
-        modPhase_ = 0.0f;
+        carrierPhase_ = 0;
+        modPhase_ = 0;
         lastMod_ = 0.0f;
     }
 
     void setFrequency(float freq) {
-        baseFreq_ = clamp(freq, MIN_FREQ, MAX_FREQ);
+        dirty_ |= assignIfChanged(baseFreq_, clamp(freq, MIN_FREQ, MAX_FREQ));
+    }
+
+    void setIndex(float normalized) {
+        dirty_ |= assignIfChanged(index_, clamp(normalized, 0.0f, 1.0f));
+    }
+
+    void setRatio(float normalized) {
+        dirty_ |= assignIfChanged(ratio_, clamp(normalized, 0.0f, 1.0f));
+    }
+
+    void setFeedback(float normalized) {
+        dirty_ |= assignIfChanged(feedback_, clamp(normalized, 0.0f, 1.0f));
+    }
+
+    void setFold(float normalized) {
+        dirty_ |= assignIfChanged(fold_, clamp(normalized, 0.0f, 1.0f));
     }
 
     void trigger() {
         reset();
     }
 
-    float process(float index, float ratio, float feedback, float fold, float envelope) {
-        float ratioVal = 0.25f + ratio * 5.75f;  // 0.25x to 6x
-        float indexVal = expMap(index, 0.15f, 8.0f);
-        float feedbackVal = clamp(feedback, 0.0f, 1.0f) * 0.9f;
+    // Commit staged controls into per-block coefficients
+    void prepare() {
+        if (!dirty_) return;
+        dirty_ = false;
 
-        float modPhaseInc = (baseFreq_ * ratioVal) / sampleRate_;
-        modPhase_ += modPhaseInc;
-        if (modPhase_ >= 1.0f) modPhase_ -= 1.0f;
+        float ratioVal = 0.25f + ratio_ * 5.75f;  // 0.25x to 6x
+        indexDepth_ = indexDepth(index_);
+        feedbackVal_ = feedback_ * 0.9f;
+        modPhaseInc_ = phaseIncrement(baseFreq_ * ratioVal, sampleRate_);
+        carrierPhaseInc_ = phaseIncrement(baseFreq_, sampleRate_);
+        folding_ = fold_ > 0.01f;
+        // sin(x * drive * pi) is half a cycle per unit of drive
+        foldCycles_ = (1.0f + fold_ * 4.0f) * 0.5f;
+    }
+
+    float process(float envelope) {
+        float out;
+        processBlock(&out, &envelope, 1);
+        return out;
+    }
 
-        float modInput = modPhase_ + lastMod_ * feedbackVal;
-        float modSignal = sinf(modInput * 2.0f * M_PI);
-        lastMod_ = modSignal;
+    // Per-sample index, feedback and fold (0-1) are optional; without them
+    // the staged values hold for the block
+    void processBlock(float* out, const float* envelope, int numSamples,
+                      const float* index = nullptr, const float* feedback = nullptr, const float* fold = nullptr) {
+        prepare();
+        if (!index && !feedback && !fold) {
+            renderBlock<false>(out, envelope, numSamples, nullptr, nullptr, nullptr);
+            return;
+        }
 
-        float carrierPhaseInc = baseFreq_ / sampleRate_;
-        carrierPhase_ += carrierPhaseInc;
-        if (carrierPhase_ >= 1.0f) carrierPhase_ -= 1.0f;
+        if (index) {
+            // Geometric steps between the depths at the ends of the ramp,
+            // one powf per block instead of per sample
+            float depth = indexDepth(clamp(index[0], 0.0f, 1.0f));
+            float last = indexDepth(clamp(index[numSamples - 1], 0.0f, 1.0f));
+            float ratio = numSamples > 1 ? powf(last / depth, 1.0f / static_cast<float>(numSamples - 1)) : 1.0f;
+            for (int i = 0; i < numSamples; ++i) {
+                depths_[i] = depth;
+                depth *= ratio;
+            }
+        } else {
+            fill(depths_, indexDepth_, numSamples);
+        }
+        if (feedback) {
+            for (int i = 0; i < numSamples; ++i) {
+                feedbacks_[i] = clamp(feedback[i], 0.0f, 1.0f) * 0.9f;
+            }
+        } else {
+            fill(feedbacks_, feedbackVal_, numSamples);
+        }
+        if (fold) {
+            for (int i = 0; i < numSamples; ++i) {
+                folds_[i] = clamp(fold[i], 0.0f, 1.0f);
+            }
+        } else {
+            fill(folds_, folding_ ? fold_ : 0.0f, numSamples);
+        }
+        renderBlock<true>(out, envelope, numSamples, depths_, feedbacks_, folds_);
+    }
 
-        float phase = carrierPhase_ + modSignal * indexVal * 0.2f;
-        float output = sinf(phase * 2.0f * M_PI);
+private:
+    static float indexDepth(float index) {
+        return expMap(index, 0.15f, 8.0f) * 0.2f;
+    }
 
-        if (fold > 0.01f) {
-            float drive = 1.0f + fold * 4.0f;
-            float folded = sinf(output * drive * M_PI);
-            output = output * (1.0f - fold) + folded * fold;
+    static void fill(float* values, float value, int numSamples) {
+        for (int i = 0; i < numSamples; ++i) {
+            values[i] = value;
         }
+    }
+
+    template<bool kRamped>
+    void renderBlock(float* out, const float* envelope, int numSamples,
+                     const float* depths, const float* feedbacks, const float* folds) {
+        for (int i = 0; i < numSamples; ++i) {
+            const float feedbackVal = kRamped ? feedbacks[i] : feedbackVal_;
+            const float depth = kRamped ? depths[i] : indexDepth_;
+
+            modPhase_ += modPhaseInc_;
+
+            Phase modInput = modPhase_ + phaseFromCycles(lastMod_ * feedbackVal);
+            float modSignal = sineLookup(modInput);
+            lastMod_ = modSignal;
+
+            carrierPhase_ += carrierPhaseInc_;
 
-        output *= envelope;
-        return fastTanh(output);
+            Phase phase = carrierPhase_ + phaseFromCycles(modSignal * depth);
+            float output = sineLookup(phase);
+
+            if (kRamped) {
+                // sin(x * drive * pi) is half a cycle per unit of drive
+                const float fold = folds[i];
+                float folded = sineLookup(phaseFromCycles(output * (1.0f + fold * 4.0f) * 0.5f));
+                output = output * (1.0f - fold) + folded * fold;
+            } else if (folding_) {
+                float folded = sineLookup(phaseFromCycles(output * foldCycles_));
+                output = output * (1.0f - fold_) + folded * fold_;
+            }
+
+            output *= envelope[i];
+            out[i] = fastTanh(output);
+        }
     }
 
-private:
     float sampleRate_;
     float baseFreq_;
-    float carrierPhase_;
-    float modPhase_;
+    Phase carrierPhase_;
+    Phase modPhase_;
     float lastMod_;
+
+    // Staged controls
+    float index_;
+    float ratio_;
+    float feedback_;
+    float fold_;
+    bool dirty_;
+
+    // Committed coefficients
+    float indexDepth_;
+    float feedbackVal_;
+    Phase modPhaseInc_;
+    Phase carrierPhaseInc_;
+    bool folding_;
+    float foldCycles_;
+
+    // Per-sample controls of a ramped block
+    float depths_[AUDIO_BLOCK_SIZE];
+    float feedbacks_[AUDIO_BLOCK_SIZE];
+    float folds_[AUDIO_BLOCK_SIZE];
 };
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+
+// Shared oscillator core for all voices.
+//
+// Phase is a 32-bit fixed-point fraction of a cycle: the accumulator wraps
+// on its own, so there is no compare-and-subtract and no precision loss at
+// low pitches. sineLookup() reads a compile-time sine table with linear
+// interpolation (1024 points: peak error 4.7e-6, about -106 dB; harmonics
+// and noise about -116 dB, per DspBench --purity).
+
+using Phase = uint32_t;
+
+struct SineTable {
+    static constexpr int kBits = 10;
+    static constexpr int kSize = 1 << kBits;
+    static constexpr int kFracBits = 32 - kBits;
+
+    // One guard point so interpolation never wraps the index
+    float value[kSize + 1];
+};
+
+namespace sine_table_detail {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Taylor series, accurate to double precision for |x| <= pi
+constexpr double taylorSin(double x) {
+    double x2 = x * x;
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 14; ++n) {
+        term *= -x2 / static_cast<double>((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr SineTable makeSineTable() {
+    SineTable table{};
+    for (int i = 0; i <= SineTable::kSize; ++i) {
+        double x = 2.0 * kPi * static_cast<double>(i) / static_cast<double>(SineTable::kSize);
+        if (x > kPi) x -= 2.0 * kPi;
+        table.value[i] = static_cast<float>(taylorSin(x));
+    }
+    return table;
+}
+
+}  // namespace sine_table_detail
+
+inline constexpr SineTable kSineTable = sine_table_detail::makeSineTable();
+
+// Per-sample increment for a frequency below sampleRate. Computed in
+// double at control rate so low pitches keep their full 32-bit precision.
+inline Phase phaseIncrement(float freq, float sampleRate) {
+    double cycles = static_cast<double>(freq) / static_cast<double>(sampleRate);
+    return static_cast<Phase>(cycles * 4294967296.0);
+}
+
+// Signed phase offset in cycles (|cycles| < 128) for phase modulation and
+// folding, at 24-bit resolution
+inline Phase phaseFromCycles(float cycles) {
+    return static_cast<Phase>(static_cast<int32_t>(cycles * 16777216.0f)) << 8;
+}
+
+inline float sineLookup(Phase phase) {
+    constexpr uint32_t kFracMask = (1u << SineTable::kFracBits) - 1u;
+    constexpr float kFracScale = 1.0f / static_cast<float>(1u << SineTable::kFracBits);
+    uint32_t index = phase >> SineTable::kFracBits;
+    float frac = static_cast<float>(phase & kFracMask) * kFracScale;
+    float a = kSineTable.value[index];
+    return a + (kSineTable.value[index + 1] - a) * frac;
+}
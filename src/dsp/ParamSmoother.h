@@ -0,0 +1,258 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include "Config.h"
+#include "Parameters.h"
+#include "ParamTable.h"
+#include "Utils.h"
+
+// Smoothing of the continuous parameters on the DSP core.
+//
+// A parameter whose table entry has a SmoothMode does not step when a new
+// value arrives: the value becomes a target, and process() moves towards it
+// a block at a time, LINEAR over a fixed time or ONE_POLE exponentially.
+// The per-sample values of each block are kept as a ramp the voices can
+// render from (ParamRamps). Parameters at their target are skipped and have
+// no ramp, so static controls cost nothing. A LINEAR parameter can also be
+// given a path of several values (setPath), ramped through in turn; pitch CV
+// uses it for every ADC sample of a block period.
+
+// Parameters with a SmoothMode, and each one's ramp slot
+constexpr ParamMask smoothedParams() {
+    ParamMask mask = 0;
+    for (const ParamDesc& desc : kParams) {
+        if (desc.smoothMode != SmoothMode::STEP) mask |= paramBit(desc.id);
+    }
+    return mask;
+}
+
+constexpr ParamMask kSmoothedParams = smoothedParams();
+
+constexpr int rampSlot(int id) {
+    int slot = 0;
+    for (int i = 0; i < id; ++i) {
+        if (kSmoothedParams & (static_cast<ParamMask>(1) << i)) ++slot;
+    }
+    return slot;
+}
+
+constexpr int kRampCount = rampSlot(static_cast<int>(ParamId::NUM_PARAMS));
+
+// Per-sample values of the parameters that moved in the last block
+class ParamRamps {
+public:
+    using Ramp = float[AUDIO_BLOCK_SIZE];
+
+    ParamRamps()
+        : ramps_(nullptr)
+        , moving_(0)
+    {
+    }
+
+    ParamRamps(const Ramp* ramps, ParamMask moving)
+        : ramps_(ramps)
+        , moving_(moving)
+    {
+    }
+
+    // nullptr when the parameter holds still
+    const float* get(ParamId id) const {
+        return (moving_ & paramBit(id)) ? ramps_[rampSlot(static_cast<int>(id))] : nullptr;
+    }
+
+    ParamMask getMoving() const {
+        return moving_;
+    }
+
+private:
+    const Ramp* ramps_;
+    ParamMask moving_;
+};
+
+class ParamSmoother {
+public:
+    explicit ParamSmoother(float sampleRate = SAMPLE_RATE)
+        : moving_(0)
+        , ramped_(0)
+    {
+        for (const ParamDesc& desc : kParams) {
+            if (desc.smoothMode == SmoothMode::STEP) continue;
+            Channel& channel = channels_[rampSlot(static_cast<int>(desc.id))];
+            channel.remaining = 0;
+            channel.step = 0.0f;
+            channel.pathCount = 0;
+            channel.pathIndex = 0;
+            channel.pathSpacing = 1;
+            if (desc.smoothMode == SmoothMode::LINEAR) {
+                int samples = static_cast<int>(desc.smoothing * 0.001f * sampleRate + 0.5f);
+                channel.rampSamples = samples > 1 ? samples : 1;
+                channel.coef = 0.0f;
+            } else {
+                // The per-block coefficient spread over the block's samples
+                channel.rampSamples = 0;
+                channel.coef = 1.0f - powf(1.0f - desc.smoothing, 1.0f / static_cast<float>(AUDIO_BLOCK_SIZE));
+            }
+        }
+        reset(makeDefaultParams());
+    }
+
+    // Jump to the values in params
+    void reset(const ParamMessage& params) {
+        for (const ParamDesc& desc : kParams) {
+            if (desc.smoothMode == SmoothMode::STEP) continue;
+            Channel& channel = channels_[rampSlot(static_cast<int>(desc.id))];
+            channel.value = clamp(params.*desc.value, desc.min, desc.max);
+            channel.target = channel.value;
+            channel.remaining = 0;
+            channel.pathCount = 0;
+        }
+        moving_ = 0;
+        ramped_ = 0;
+    }
+
+    // New targets for the smoothed parameters in `changed`
+    void setTargets(const ParamMessage& params, ParamMask changed) {
+        changed &= kSmoothedParams;
+        if (changed == 0) return;
+        for (const ParamDesc& desc : kParams) {
+            if (changed & paramBit(desc.id)) setTarget(desc.id, params.*desc.value);
+        }
+    }
+
+    void setTarget(ParamId id, float target) {
+        const ParamDesc& desc = paramDesc(id);
+        Channel& channel = channels_[rampSlot(static_cast<int>(id))];
+        if (!assignIfChanged(channel.target, clamp(target, desc.min, desc.max))) return;
+        channel.pathCount = 0;
+        if (desc.smoothMode == SmoothMode::LINEAR) {
+            // A new target restarts the ramp from where the value is now
+            channel.remaining = channel.rampSamples;
+            channel.step = (channel.target - channel.value) / static_cast<float>(channel.rampSamples);
+        }
+        moving_ |= paramBit(id);
+    }
+
+    // Ramp a LINEAR parameter from where it is through points[0..count) in
+    // turn, spacing samples apart (a path of more than kMaxPathPoints keeps
+    // the newest). Replaces any ramp in progress.
+    void setPath(ParamId id, const float* points, int count, int spacing) {
+        const ParamDesc& desc = paramDesc(id);
+        if (desc.smoothMode != SmoothMode::LINEAR || count <= 0) return;
+        if (count > kMaxPathPoints) {
+            points += count - kMaxPathPoints;
+            count = kMaxPathPoints;
+        }
+        Channel& channel = channels_[rampSlot(static_cast<int>(id))];
+        for (int i = 0; i < count; ++i) {
+            channel.path[i] = clamp(points[i], desc.min, desc.max);
+        }
+        channel.pathCount = count;
+        channel.pathIndex = 0;
+        channel.pathSpacing = spacing > 1 ? spacing : 1;
+        channel.target = channel.path[count - 1];
+        channel.remaining = 0;
+        moving_ |= paramBit(id);
+    }
+
+    // Move the parameters that are not at their target by numSamples (at
+    // most AUDIO_BLOCK_SIZE), filling their ramps; returns which moved
+    ParamMask process(int numSamples) {
+        ramped_ = moving_;
+        if (moving_ == 0) return 0;
+        for (const ParamDesc& desc : kParams) {
+            if (!(moving_ & paramBit(desc.id))) continue;
+            int slot = rampSlot(static_cast<int>(desc.id));
+            bool settled = desc.smoothMode == SmoothMode::LINEAR
+                ? advanceLinear(channels_[slot], ramps_[slot], numSamples)
+                : advanceOnePole(channels_[slot], ramps_[slot], numSamples);
+            if (settled) moving_ &= ~paramBit(desc.id);
+        }
+        return ramped_;
+    }
+
+    // Ramps of the last process()
+    ParamRamps getRamps() const {
+        return ParamRamps(ramps_, ramped_);
+    }
+
+    // Where the parameter is now (its target when it holds still)
+    float getValue(ParamId id) const {
+        return channels_[rampSlot(static_cast<int>(id))].value;
+    }
+
+    // Current values of the smoothed parameters into params
+    void writeValues(ParamMessage& params) const {
+        for (const ParamDesc& desc : kParams) {
+            if (desc.smoothMode == SmoothMode::STEP) continue;
+            params.*desc.value = channels_[rampSlot(static_cast<int>(desc.id))].value;
+        }
+    }
+
+    ParamMask getMoving() const {
+        return moving_;
+    }
+
+private:
+    // Closer than this to the target a one-pole snaps to it
+    static constexpr float kSettleThreshold = 1.0e-4f;
+    static constexpr int kMaxPathPoints = 8;
+
+    struct Channel {
+        float value;
+        float target;
+        float step;        // LINEAR: per sample
+        float coef;        // ONE_POLE: per sample
+        int rampSamples;   // LINEAR: length of a ramp
+        int remaining;     // LINEAR: samples left in the current ramp
+        float path[kMaxPathPoints];  // LINEAR: setPath() points, ramped through in turn
+        int pathCount;
+        int pathIndex;     // Next point to ramp to
+        int pathSpacing;
+    };
+
+    static bool advanceLinear(Channel& channel, float* ramp, int numSamples) {
+        float value = channel.value;
+        int remaining = channel.remaining;
+        // A path leg in progress ends at its point, not the path's end
+        float end = channel.pathIndex > 0 && channel.pathCount > 0
+            ? channel.path[channel.pathIndex - 1] : channel.target;
+        for (int i = 0; i < numSamples; ++i) {
+            if (remaining == 0 && channel.pathIndex < channel.pathCount) {
+                // Next leg of a path
+                end = channel.path[channel.pathIndex++];
+                remaining = channel.pathSpacing;
+                channel.step = (end - value) / static_cast<float>(remaining);
+            }
+            if (remaining > 0) {
+                value = (--remaining > 0) ? value + channel.step : end;
+            }
+            ramp[i] = value;
+        }
+        channel.value = value;
+        channel.remaining = remaining;
+        if (remaining == 0 && channel.pathIndex >= channel.pathCount) {
+            channel.pathCount = 0;
+            return true;
+        }
+        return false;
+    }
+
+    static bool advanceOnePole(Channel& channel, float* ramp, int numSamples) {
+        float value = channel.value;
+        const float target = channel.target;
+        const float coef = channel.coef;
+        for (int i = 0; i < numSamples; ++i) {
+            value += (target - value) * coef;
+            ramp[i] = value;
+        }
+        bool settled = fabsf(target - value) < kSettleThreshold;
+        channel.value = settled ? target : value;
+        return settled;
+    }
+
+    Channel channels_[kRampCount > 0 ? kRampCount : 1];
+    float ramps_[kRampCount > 0 ? kRampCount : 1][AUDIO_BLOCK_SIZE];
+    ParamMask moving_;
+    ParamMask ramped_;  // Moved in the last process(), so have a ramp
+};
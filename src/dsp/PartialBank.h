@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cstring>
+#include "Config.h"
+
+// Additive partial bank in structure-of-arrays layout.
+//
+// Each partial is a unit complex phasor (re, im) rotated every sample by
+// (cos w, sin w); its output is im, i.e. sin of the accumulated phase. The
+// rotation has no table lookups or wraps, and lane groups of partials
+// update in parallel: 4-wide vectors on hosts with SSE/NEON, plain floats
+// (still branch-free) on the ESP32. Magnitudes drift by float rounding
+// only, and finishBlock() pulls them back once per block.
+//
+// Every partial also carries its own exponential envelope, multiplied by a
+// per-partial decay coefficient each sample in the same lanes. trigger()
+// restarts all envelopes at full level.
+//
+// Partials are used as a prefix: setActive(n) renders partials [0, n), so
+// culling the ones above Nyquist is just a smaller count for the block.
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+typedef float PartialLanes __attribute__((vector_size(16)));
+#else
+typedef float PartialLanes;
+#endif
+
+class PartialBank {
+public:
+    static constexpr int kLaneWidth = sizeof(PartialLanes) / sizeof(float);
+    static constexpr int kGroups = (MAX_HARMONICS + kLaneWidth - 1) / kLaneWidth;
+    static constexpr int kCapacity = kGroups * kLaneWidth;
+
+    PartialBank()
+        : active_(0)
+        , activeGroups_(0)
+    {
+        for (int i = 0; i < kCapacity; ++i) {
+            cos_[i] = 1.0f;
+            sin_[i] = 0.0f;
+            amp_[i] = 0.0f;
+            chaosDepth_[i] = 0.0f;
+            decay_[i] = 1.0f;
+        }
+        reset();
+    }
+
+    // Phase 0 and full envelope for every partial
+    void reset() {
+        for (int i = 0; i < kCapacity; ++i) {
+            re_[i] = 1.0f;
+            im_[i] = 0.0f;
+        }
+        trigger();
+    }
+
+    void trigger() {
+        for (int i = 0; i < kCapacity; ++i) {
+            env_[i] = 1.0f;
+        }
+    }
+
+    // Control rate: rotation per sample as (cos w, sin w), amplitude, chaos
+    // modulation depth and per-sample envelope decay of one partial
+    void setPartial(int index, float cosW, float sinW, float amp, float chaosDepth, float decay) {
+        cos_[index] = cosW;
+        sin_[index] = sinW;
+        amp_[index] = amp;
+        chaosDepth_[index] = chaosDepth;
+        decay_[index] = decay;
+    }
+
+    void setActive(int count) {
+        // Silence the padding lanes of the last group
+        int groups = (count + kLaneWidth - 1) / kLaneWidth;
+        for (int i = count; i < groups * kLaneWidth; ++i) {
+            amp_[i] = 0.0f;
+        }
+        active_ = count;
+        activeGroups_ = groups;
+    }
+
+    int getActive() const {
+        return active_;
+    }
+
+    // Render the sum of active partials into sum[0..n) and their summed
+    // amplitude (for normalization) into totalAmp[0..n). Each partial's
+    // amplitude is amp * envelope; with kChaotic it is further scaled per
+    // sample by max(0.15, 1 + depth * chaos[n]).
+    template<bool kChaotic>
+    void render(float* sum, float* totalAmp, const float* chaos, int numSamples) {
+        for (int n = 0; n < numSamples; ++n) {
+            acc_[n] = splat(0.0f);
+            accAmp_[n] = splat(0.0f);
+        }
+
+        for (int g = 0; g < activeGroups_; ++g) {
+            const int base = g * kLaneWidth;
+            PartialLanes re = load(re_ + base);
+            PartialLanes im = load(im_ + base);
+            const PartialLanes c = load(cos_ + base);
+            const PartialLanes s = load(sin_ + base);
+            const PartialLanes amp = load(amp_ + base);
+            const PartialLanes depth = load(chaosDepth_ + base);
+            const PartialLanes decay = load(decay_ + base);
+            PartialLanes env = load(env_ + base);
+
+            for (int n = 0; n < numSamples; ++n) {
+                PartialLanes nextRe = re * c - im * s;
+                im = re * s + im * c;
+                re = nextRe;
+
+                env *= decay;
+                PartialLanes a = amp * env;
+                if (kChaotic) {
+                    a *= laneMax(depth * chaos[n] + 1.0f, splat(0.15f));
+                }
+                acc_[n] += a * im;
+                accAmp_[n] += a;
+            }
+
+            store(re_ + base, re);
+            store(im_ + base, im);
+            store(env_ + base, env);
+        }
+
+        for (int n = 0; n < numSamples; ++n) {
+            sum[n] = laneSum(acc_[n]);
+            totalAmp[n] = laneSum(accAmp_[n]);
+        }
+    }
+
+    // Once per block: one Newton step towards |phasor| = 1, and envelopes
+    // that have died away are zeroed before they reach denormals
+    void finishBlock() {
+        constexpr float kSilentEnv = 1e-5f;
+        for (int g = 0; g < activeGroups_; ++g) {
+            const int base = g * kLaneWidth;
+            PartialLanes re = load(re_ + base);
+            PartialLanes im = load(im_ + base);
+            PartialLanes gain = 1.5f - 0.5f * (re * re + im * im);
+            store(re_ + base, re * gain);
+            store(im_ + base, im * gain);
+
+            PartialLanes env = load(env_ + base);
+            store(env_ + base, env > splat(kSilentEnv) ? env : splat(0.0f));
+        }
+    }
+
+private:
+    static PartialLanes splat(float value) {
+        return PartialLanes{} + value;
+    }
+
+    static PartialLanes load(const float* src) {
+        PartialLanes lanes;
+        std::memcpy(&lanes, src, sizeof(lanes));
+        return lanes;
+    }
+
+    static void store(float* dst, PartialLanes lanes) {
+        std::memcpy(dst, &lanes, sizeof(lanes));
+    }
+
+    static PartialLanes laneMax(PartialLanes a, PartialLanes b) {
+        return a > b ? a : b;
+    }
+
+    static float laneSum(PartialLanes lanes) {
+#if defined(__SSE2__) || defined(__ARM_NEON)
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+        return lanes;
+#endif
+    }
+
+    alignas(16) float re_[kCapacity];
+    alignas(16) float im_[kCapacity];
+    alignas(16) float cos_[kCapacity];
+    alignas(16) float sin_[kCapacity];
+    alignas(16) float amp_[kCapacity];
+    alignas(16) float chaosDepth_[kCapacity];
+    alignas(16) float decay_[kCapacity];
+    alignas(16) float env_[kCapacity];
+    // Per-sample lane sums of render(); members rather than locals, as
+    // the DSP task stack cannot hold block buffers this size
+    PartialLanes acc_[AUDIO_BLOCK_SIZE];
+    PartialLanes accAmp_[AUDIO_BLOCK_SIZE];
+    int active_;
+    int activeGroups_;
+};
@@ -4,15 +4,54 @@
 #include <cstdint>
 #include "Config.h"
 #include "Utils.h"
+#include "DelayLine.h"
+#include "MixingMatrix.h"
+#include "Parameters.h"
+#include "VoiceArena.h"
 
 // Pitched verb resonator: comb + allpass tuned by base frequency
 // FEEDBACK: controls self-oscillation amount
 // DAMP: high-frequency damping in the feedback loop
 // MIX: wet/dry mix
 // EXCITE: transient burst level on trigger
+// MODE: COMB = four parallel saturating combs (metallic)
+//       FDN = the same four lines as a feedback delay network mixed by a
+//       Hadamard matrix, with per-line gain and damping (denser, smoother)
+//
+// Feedback/damp/mix are staged by the setters and turned into loop
+// coefficients by prepare() only when they change; mix can also be given
+// per sample while it glides. Delay times are
+// fractional and glide to a new pitch, so the resonator follows pitch CV
+// without resetting its lines.
+//
+// The delay lines (~80 KB) are not part of the object: acquire() borrows
+// them from a VoiceArena when the voice is activated and release() returns
+// them. Without lines the verb renders silence.
 
 class PitchedVerb {
+    // Line layout, private; declared first so kArenaBytes can size it
+    static constexpr int kCombCount = 4;
+    static constexpr int kAllpassCount = 2;
+    static constexpr int kMaxCombDelay = 4096;
+    static constexpr int kMaxAllpassDelay = 2048;
+
+    // Line lengths relative to the pitch period
+    static constexpr float kCombRatios[kCombCount] = {1.0f, 1.3333f, 1.5f, 2.0f};
+
+    using CombLine = DelayLine<float, kMaxCombDelay>;
+    using AllpassLine = DelayLine<float, kMaxAllpassDelay>;
+
+    // Everything borrowed from the arena
+    struct Lines {
+        CombLine combs[kCombCount];
+        float combFilter[kCombCount];
+        AllpassLine allpasses[kAllpassCount];
+    };
+
 public:
+    // Arena bytes one verb borrows while active
+    static constexpr size_t kArenaBytes = VoiceArena::footprint<Lines>();
+
     explicit PitchedVerb(float sampleRate = SAMPLE_RATE)
         : sampleRate_(sampleRate)
         , baseFreq_(220.0f)
@@ -24,47 +63,64 @@ public:
         , excitePhaseInc_(0.0f)
         , dcBlocker_(0.0f)
         , dcBlockerPrev_(0.0f)
+        , feedback_(0.4f)
+        , damp_(0.3f)
+        , mix_(0.6f)
+        , mode_(VerbMode::COMB)
+        , dirty_(true)
+        , glide_(1.0f - expf(-1.0f / (kDelayGlideTime * sampleRate)))
+        , lines_(nullptr)
     {
+        prepare();
+    }
+
+    // Borrow the delay lines; they start cleared and tuned to the current
+    // pitch. Returns false when the arena is out of room.
+    bool acquire(VoiceArena& arena) {
+        if (lines_) return true;
+        lines_ = arena.create<Lines>();
+        if (!lines_) return false;
+
+        for (int i = 0; i < kCombCount; ++i) {
+            lines_->combs[i].setGlide(glide_);
+        }
+        for (int i = 0; i < kAllpassCount; ++i) {
+            lines_->allpasses[i].setGlide(glide_);
+        }
         reset();
         updateDelays();
+        snapDelays();
+        return true;
+    }
+
+    void release(VoiceArena& arena) {
+        arena.destroy(lines_);
+    }
+
+    bool hasLines() const {
+        return lines_ != nullptr;
     }
 
     void reset() {
+        dcBlocker_ = 0.0f;
+        dcBlockerPrev_ = 0.0f;
+        if (!lines_) return;
+
         for (int i = 0; i < kCombCount; ++i) {
-            for (int j = 0; j < kMaxCombDelay; ++j) {
-                combBuffers_[i][j] = 0.0f;
-            }
-            combIndex_[i] = 0;
-            combFilter_[i] = 0.0f;
+            lines_->combs[i].clear();
+            lines_->combFilter[i] = 0.0f;
         }
         for (int i = 0; i < kAllpassCount; ++i) {
-            for (int j = 0; j < kMaxAllpassDelay; ++j) {
-                allpassBuffers_[i][j] = 0.0f;
-            }
-            allpassIndex_[i] = 0;
+            lines_->allpasses[i].clear();
         }
-        dcBlocker_ = 0.0f;
-        dcBlockerPrev_ = 0.0f;
     }
 
     void setFrequency(float freq) {
-        float newFreq = clamp(freq, MIN_FREQ, MAX_FREQ);
-        // Only update delays if frequency changed significantly (avoid clicks from ADC noise)
-        if (fabsf(newFreq - baseFreq_) > 2.0f) {
-            baseFreq_ = newFreq;
+        // New delay targets; the lines glide there, so ADC noise and CV
+        // sweeps retune without clicks
+        if (assignIfChanged(baseFreq_, clamp(freq, MIN_FREQ, MAX_FREQ))) {
             excitePhaseInc_ = baseFreq_ / sampleRate_;
             updateDelays();
-            // Reset indices and filter states to prevent discontinuities
-            for (int i = 0; i < kCombCount; ++i) {
-                combIndex_[i] = 0;
-                combFilter_[i] = 0.0f;
-            }
-            for (int i = 0; i < kAllpassCount; ++i) {
-                allpassIndex_[i] = 0;
-            }
-            // Reset DC blocker state
-            dcBlocker_ = 0.0f;
-            dcBlockerPrev_ = 0.0f;
         }
     }
 
@@ -77,104 +133,205 @@ public:
         exciteLevel_ = clamp(normalized, 0.0f, 1.0f);
     }
 
-    float process(float feedback, float damp, float mix, float envelope) {
+    void setFeedback(float normalized) {
+        dirty_ |= assignIfChanged(feedback_, clamp(normalized, 0.0f, 1.0f));
+    }
+
+    void setDamp(float normalized) {
+        dirty_ |= assignIfChanged(damp_, clamp(normalized, 0.0f, 1.0f));
+    }
+
+    void setMix(float normalized) {
+        dirty_ |= assignIfChanged(mix_, clamp(normalized, 0.0f, 1.0f));
+    }
+
+    // Both modes run on the same delay lines, so switching costs no memory
+    // and the tail carries over
+    void setMode(VerbMode mode) {
+        mode_ = mode;
+    }
+
+    // Commit staged controls into loop coefficients
+    void prepare() {
+        if (!dirty_) return;
+        dirty_ = false;
+
         // Feedback: 0.5 at min (fast decay), up to 0.92 at max (long sustain)
-        const float fb = 0.5f + feedback * 0.42f;
-        const float dampCoef = clamp(damp, 0.0f, 1.0f);
+        fb_ = 0.5f + feedback_ * 0.42f;
+        // Simple lowpass in feedback path
+        lpCoef_ = 0.3f + (1.0f - damp_) * 0.65f;
+        dryMix_ = 1.0f - mix_;
+
+        // FDN: longer lines lose more per pass, so every line decays at the
+        // same rate in seconds
+        for (int i = 0; i < kCombCount; ++i) {
+            lineGain_[i] = powf(fb_, kCombRatios[i]);
+            lineDamp_[i] = powf(lpCoef_, kCombRatios[i]);
+        }
+    }
 
-        // Excitation: impulse + decaying burst (no continuous oscillator)
-        float input = 0.0f;
+    float process(float envelope) {
+        float out;
+        processBlock(&out, &envelope, 1);
+        return out;
+    }
 
-        if (impulsePending_) {
-            input += 1.0f + exciteLevel_ * 0.5f;
-            impulsePending_ = false;
+    // Per-sample mix (0-1) is optional; without it the staged value holds
+    // for the block
+    void processBlock(float* out, const float* envelope, int numSamples, const float* mix = nullptr) {
+        prepare();
+        if (!lines_) {
+            for (int i = 0; i < numSamples; ++i) {
+                out[i] = 0.0f;
+            }
+            return;
         }
+        if (mode_ == VerbMode::FDN) {
+            if (mix) {
+                renderBlock<true, true>(out, envelope, mix, numSamples);
+            } else {
+                renderBlock<true, false>(out, envelope, nullptr, numSamples);
+            }
+        } else if (mix) {
+            renderBlock<false, true>(out, envelope, mix, numSamples);
+        } else {
+            renderBlock<false, false>(out, envelope, nullptr, numSamples);
+        }
+    }
 
-        if (excite_ > 0.0001f) {
-            input += excite_ * (0.8f + exciteLevel_ * 0.4f);
-            excite_ *= 0.93f;
+    void getDelayStats(int &comb0, int &comb1, int &comb2, int &comb3, int &ap0, int &ap1) const {
+        if (!lines_) {
+            comb0 = comb1 = comb2 = comb3 = ap0 = ap1 = 0;
+            return;
+        }
+        comb0 = static_cast<int>(lines_->combs[0].getDelay() + 0.5f);
+        comb1 = static_cast<int>(lines_->combs[1].getDelay() + 0.5f);
+        comb2 = static_cast<int>(lines_->combs[2].getDelay() + 0.5f);
+        comb3 = static_cast<int>(lines_->combs[3].getDelay() + 0.5f);
+        ap0 = static_cast<int>(lines_->allpasses[0].getDelay() + 0.5f);
+        ap1 = static_cast<int>(lines_->allpasses[1].getDelay() + 0.5f);
+    }
+
+    float getBaseFreq() const {
+        return baseFreq_;
+    }
+
+private:
+    static constexpr float kAntiDenormal = 1e-18f;
+
+    template<bool kFdn, bool kRamped>
+    void renderBlock(float* out, const float* envelope, const float* mixRamp, int numSamples) {
+        const float stagedMix = mix_;
+        const float stagedDryMix = dryMix_;
+        AllpassLine* allpasses = lines_->allpasses;
+
+        for (int n = 0; n < numSamples; ++n) {
+            // Excitation: impulse + decaying burst (no continuous oscillator)
+            float input = 0.0f;
+
+            if (impulsePending_) {
+                input += 1.0f + exciteLevel_ * 0.5f;
+                impulsePending_ = false;
+            }
+
+            if (excite_ > 0.0001f) {
+                input += excite_ * (0.8f + exciteLevel_ * 0.4f);
+                excite_ *= 0.93f;
+            }
+
+            float resonatorOut = kFdn ? fdnStep(input) : combStep(input);
+
+            // Allpass diffusion section
+            float diffused = resonatorOut;
+            for (int i = 0; i < kAllpassCount; ++i) {
+                float delayed = allpasses[i].tap();
+                const float g = 0.5f;
+                float next = -diffused * g + delayed;
+                allpasses[i].write(diffused + delayed * g);
+                diffused = next;
+            }
+
+            // Mix: 0 = pure resonator (metallic), 1 = full diffusion (reverb-like)
+            const float mix = kRamped ? clamp(mixRamp[n], 0.0f, 1.0f) : stagedMix;
+            const float dryMix = kRamped ? 1.0f - mix : stagedDryMix;
+            float output = resonatorOut * dryMix + diffused * mix;
+
+            // Apply envelope and output gain
+            output *= envelope[n] * 10.0f;
+            out[n] = fastTanh(output);
         }
+    }
+
+    // Parallel combs, each saturating its own feedback
+    float combStep(float input) {
+        const float fb = fb_;
+        const float lpCoef = lpCoef_;
+        CombLine* combs = lines_->combs;
+        float* combFilter = lines_->combFilter;
 
         float combSum = 0.0f;
         for (int i = 0; i < kCombCount; ++i) {
-            const int delay = combDelay_[i];
-            // Ensure index is always in bounds before reading
-            int idx = combIndex_[i] % delay;
-            combIndex_[i] = idx;
-            float delayed = combBuffers_[i][idx];
+            float delayed = combs[i].tap();
 
-            // Simple lowpass in feedback path
-            float lpCoef = 0.3f + (1.0f - dampCoef) * 0.65f;
-            combFilter_[i] += (delayed - combFilter_[i]) * lpCoef;
-            float filtered = combFilter_[i];
+            combFilter[i] += (delayed - combFilter[i]) * lpCoef;
+            float filtered = combFilter[i];
 
+            // The tiny DC offset keeps decaying tails out of denormals
             float feedbackSignal = filtered * fb;
-            float write = input + feedbackSignal;
+            float write = input + feedbackSignal + kAntiDenormal;
             write = fastTanh(write);
 
-            combBuffers_[i][idx] = write;
-            combIndex_[i] = (idx + 1) % delay;
+            combs[i].write(write);
             combSum += delayed;
         }
+        return combSum * (1.0f / static_cast<float>(kCombCount));
+    }
 
-        float combOut = combSum * (1.0f / static_cast<float>(kCombCount));
-
-        // Allpass diffusion section
-        float diffused = combOut;
-        for (int i = 0; i < kAllpassCount; ++i) {
-            const int delay = allpassDelay_[i];
-            // Ensure index is always in bounds before reading
-            int idx = allpassIndex_[i] % delay;
-            allpassIndex_[i] = idx;
-            float delayed = allpassBuffers_[i][idx];
-            const float g = 0.5f;
-            float next = -diffused * g + delayed;
-            allpassBuffers_[i][idx] = diffused + delayed * g;
-            allpassIndex_[i] = (idx + 1) % delay;
-            diffused = next;
+    // Feedback delay network: damp every line, mix all of them through the
+    // orthonormal Hadamard matrix, feed back with per-line gain
+    float fdnStep(float input) {
+        CombLine* combs = lines_->combs;
+        float* combFilter = lines_->combFilter;
+        float lines[kCombCount];
+        float sum = 0.0f;
+        for (int i = 0; i < kCombCount; ++i) {
+            float delayed = combs[i].tap();
+            sum += delayed;
+            combFilter[i] += (delayed - combFilter[i]) * lineDamp_[i];
+            lines[i] = combFilter[i];
         }
 
-        // Mix: 0 = pure comb (metallic), 1 = full diffusion (reverb-like)
-        float output = combOut * (1.0f - mix) + diffused * mix;
+        hadamardMix<kCombCount>(lines);
 
-        // Apply envelope and output gain
-        output *= envelope * 10.0f;
-        return fastTanh(output);
-    }
-
-    void getDelayStats(int &comb0, int &comb1, int &comb2, int &comb3, int &ap0, int &ap1) const {
-        comb0 = combDelay_[0];
-        comb1 = combDelay_[1];
-        comb2 = combDelay_[2];
-        comb3 = combDelay_[3];
-        ap0 = allpassDelay_[0];
-        ap1 = allpassDelay_[1];
+        for (int i = 0; i < kCombCount; ++i) {
+            combs[i].write(input + lines[i] * lineGain_[i] + kAntiDenormal);
+        }
+        return sum * (1.0f / static_cast<float>(kCombCount));
     }
 
-    float getBaseFreq() const {
-        return baseFreq_;
-    }
-
-private:
-    static constexpr int kCombCount = 4;
-    static constexpr int kAllpassCount = 2;
-    static constexpr int kMaxCombDelay = 4096;
-    static constexpr int kMaxAllpassDelay = 2048;
+    // Retuning time constant for delay glides (seconds)
+    static constexpr float kDelayGlideTime = 0.01f;
 
     void updateDelays() {
-        float base = sampleRate_ / baseFreq_;
-        int baseDelay = clamp(static_cast<int>(base + 0.5f), 16, kMaxCombDelay - 1);
+        if (!lines_) return;
+        float baseDelay = clamp(sampleRate_ / baseFreq_, 16.0f, CombLine::kMaxDelay);
 
-        const float ratios[kCombCount] = {1.0f, 1.3333f, 1.5f, 2.0f};
         for (int i = 0; i < kCombCount; ++i) {
-            int delay = static_cast<int>(baseDelay * ratios[i]);
-            combDelay_[i] = clamp(delay, 8, kMaxCombDelay - 1);
+            lines_->combs[i].setDelay(clamp(baseDelay * kCombRatios[i], 8.0f, CombLine::kMaxDelay));
         }
 
         const float apRatios[kAllpassCount] = {0.5f, 0.75f};
         for (int i = 0; i < kAllpassCount; ++i) {
-            int delay = static_cast<int>(baseDelay * apRatios[i]);
-            allpassDelay_[i] = clamp(delay, 4, kMaxAllpassDelay - 1);
+            lines_->allpasses[i].setDelay(clamp(baseDelay * apRatios[i], 4.0f, AllpassLine::kMaxDelay));
+        }
+    }
+
+    void snapDelays() {
+        for (int i = 0; i < kCombCount; ++i) {
+            lines_->combs[i].snap();
+        }
+        for (int i = 0; i < kAllpassCount; ++i) {
+            lines_->allpasses[i].snap();
         }
     }
 
@@ -189,12 +346,18 @@ private:
     float dcBlocker_;
     float dcBlockerPrev_;
 
-    float combBuffers_[kCombCount][kMaxCombDelay];
-    float combFilter_[kCombCount];
-    int combIndex_[kCombCount];
-    int combDelay_[kCombCount];
+    // Staged controls and committed coefficients
+    float feedback_;
+    float damp_;
+    float mix_;
+    VerbMode mode_;
+    bool dirty_;
+    float fb_;
+    float lpCoef_;
+    float dryMix_;
+    float lineGain_[kCombCount];
+    float lineDamp_[kCombCount];
 
-    float allpassBuffers_[kAllpassCount][kMaxAllpassDelay];
-    int allpassIndex_[kAllpassCount];
-    int allpassDelay_[kAllpassCount];
+    float glide_;
+    Lines* lines_;
 };
@@ -0,0 +1,263 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include "Voices.h"
+#include "Envelope.h"
+#include "VoiceArena.h"
+#include "Config.h"
+#include "Parameters.h"
+#include "ParamTable.h"
+#include "ParamSmoother.h"
+#include "Utils.h"
+
+// One slot of the engine's voice pool: an instance of every registered
+// voice, the selected one of which sounds, with its own envelope and pitch.
+//
+// A slot is available when the selected voice has its memory; a voice that
+// borrows from the arena may only fit in some slots, and the others sit
+// out until the selection changes.
+//
+// Changing the voice while the slot sounds starts a transition: outgoing
+// and incoming voices both render under the slot's envelope for a fixed
+// number of samples, crossfaded at equal power, and the outgoing voice
+// keeps its memory until the fade is over. Outside a transition only the
+// selected voice runs.
+
+class PolyVoice {
+public:
+    PolyVoice(VoiceArena& arena, float sampleRate = SAMPLE_RATE)
+        : arena_(arena)
+        , voices_(sampleRate)
+        , envelope_(sampleRate)
+        , selected_(-1)
+        , previous_(-1)
+        , fadeLength_(0)
+        , fadePos_(0)
+        , available_(false)
+        , previousAvailable_(false)
+        , held_(false)
+        , choked_(false)
+        , startOrder_(0)
+    {
+    }
+
+    PolyVoice(const PolyVoice&) = delete;
+    PolyVoice& operator=(const PolyVoice&) = delete;
+
+    // Switch to the registered voice at `index`, crossfading over
+    // fadeSamples if the slot is sounding. Returns whether the new voice
+    // found its memory; a slot whose voice does not fit fades out and
+    // goes silent.
+    bool select(int index, int fadeSamples) {
+        if (index == selected_) return available_;
+
+        if (index == previous_) {
+            // Switched back mid-fade: run the same fade in reverse
+            swapVoices();
+            fadePos_ = fadeLength_ - fadePos_;
+            return available_;
+        }
+        finishSwitch();
+
+        bool fade = fadeSamples > 0 && selected_ >= 0 && isSounding();
+        if (fade) {
+            previous_ = selected_;
+            previousAvailable_ = available_;
+            fadeLength_ = fadeSamples;
+            fadePos_ = 0;
+        } else {
+            release();
+        }
+
+        selected_ = index;
+        available_ = voices_.acquire(selected_, arena_);
+        if (!available_ && !fade) {
+            envelope_.reset();
+            held_ = false;
+        }
+        return available_;
+    }
+
+    // Hand back all borrowed memory
+    void release() {
+        finishSwitch();
+        if (available_) {
+            voices_.release(selected_, arena_);
+        }
+        available_ = false;
+    }
+
+    // Update the envelope and selected voice from the parameters in
+    // `changed`
+    void applyParams(const ParamMessage& params, ParamMask changed = kAllParams) {
+        if (changed & kEnvelopeParams) {
+            envelope_.setAttack(params.attack);
+            envelope_.setDecay(params.decay);
+            envelope_.setSustain(params.sustain);
+            envelope_.setRelease(params.release);
+            envelope_.setCurve(static_cast<EnvelopeCurve>(params.envCurve));
+        }
+        if (changed & kVoiceParams) {
+            voices_.applyParams(selected_, params);
+        }
+    }
+
+    void setFrequency(float freq) {
+        voices_.forEach([freq](auto& voice) { voice.setFrequency(freq); });
+    }
+
+    // Start a note. A slot that had gone quiet starts from clean state; a
+    // stolen one keeps its state and attacks from its current level.
+    void noteOn(float freq, uint32_t order) {
+        setFrequency(freq);
+        if (!envelope_.isActive()) {
+            voices_.forEach([](auto& voice) { voice.reset(); });
+        }
+        voices_.forEach([](auto& voice) { voice.trigger(); });
+        envelope_.trigger();
+        held_ = true;
+        choked_ = false;
+        startOrder_ = order;
+    }
+
+    void noteOff() {
+        envelope_.release();
+        held_ = false;
+    }
+
+    // Fade out quickly to free the slot's DSP time
+    void choke() {
+        envelope_.fadeOut(kChokeTime);
+        held_ = false;
+        choked_ = true;
+    }
+
+    // Re-excite the selected voice without a new envelope (voice change
+    // with the gate held)
+    void retrigger() {
+        voices_.visit(selected_, [](auto& voice) { voice.trigger(); });
+    }
+
+    // Render envelope and voice into out[0..numSamples). The selected
+    // voice follows the ramps of its moving controls; an outgoing voice
+    // keeps the controls it had.
+    void render(float* out, int numSamples, const ParamRamps& ramps = ParamRamps()) {
+        envelope_.processBlock(envelopeOut_, numSamples);
+        renderVoice(selected_, available_, out, envelopeOut_, numSamples, ramps);
+        if (previous_ < 0) return;
+
+        renderVoice(previous_, previousAvailable_, outgoing_, envelopeOut_, numSamples, ParamRamps());
+
+        // Equal-power gains at the block edges, linear in between
+        constexpr float kQuarterTurn = 1.5707963f;
+        float start = static_cast<float>(fadePos_) / static_cast<float>(fadeLength_);
+        fadePos_ += numSamples;
+        float end = fadePos_ < fadeLength_
+            ? static_cast<float>(fadePos_) / static_cast<float>(fadeLength_)
+            : 1.0f;
+        float inGain = sinf(start * kQuarterTurn);
+        float outGain = cosf(start * kQuarterTurn);
+        float inStep = (sinf(end * kQuarterTurn) - inGain) / static_cast<float>(numSamples);
+        float outStep = (cosf(end * kQuarterTurn) - outGain) / static_cast<float>(numSamples);
+        for (int i = 0; i < numSamples; ++i) {
+            inGain += inStep;
+            outGain += outStep;
+            out[i] = out[i] * inGain + outgoing_[i] * outGain;
+        }
+
+        if (fadePos_ >= fadeLength_) {
+            finishSwitch();
+            if (!available_) {
+                envelope_.reset();
+                held_ = false;
+            }
+        }
+    }
+
+    bool isAvailable() const {
+        return available_;
+    }
+
+    bool isSounding() const {
+        return (available_ || previous_ >= 0) && envelope_.isActive();
+    }
+
+    // Rendering two voices this block
+    bool isSwitching() const {
+        return previous_ >= 0;
+    }
+
+    bool isHeld() const {
+        return held_;
+    }
+
+    bool isChoked() const {
+        return choked_;
+    }
+
+    uint32_t getStartOrder() const {
+        return startOrder_;
+    }
+
+    const Envelope& getEnvelope() const {
+        return envelope_;
+    }
+
+    const ClaudiusVoices& getVoices() const {
+        return voices_;
+    }
+
+private:
+    static constexpr float kChokeTime = 0.005f;
+    static constexpr ParamMask kEnvelopeParams = paramsFeeding(STAGE_ENVELOPE);
+    static constexpr ParamMask kVoiceParams = paramsFeeding(STAGE_VOICE);
+
+    void renderVoice(int index, bool available, float* out, const float* envelope, int numSamples,
+                     const ParamRamps& ramps) {
+        if (!available) {
+            for (int i = 0; i < numSamples; ++i) {
+                out[i] = 0.0f;
+            }
+            return;
+        }
+        voices_.render(index, out, envelope, numSamples, ramps);
+    }
+
+    void swapVoices() {
+        int index = selected_;
+        selected_ = previous_;
+        previous_ = index;
+        bool available = available_;
+        available_ = previousAvailable_;
+        previousAvailable_ = available;
+    }
+
+    // Drop the outgoing voice and its memory
+    void finishSwitch() {
+        if (previous_ < 0) return;
+        if (previousAvailable_) {
+            voices_.release(previous_, arena_);
+        }
+        previous_ = -1;
+        previousAvailable_ = false;
+    }
+
+    VoiceArena& arena_;
+    ClaudiusVoices voices_;
+    Envelope envelope_;
+    int selected_;
+    int previous_;        // Outgoing voice during a transition, or -1
+    int fadeLength_;
+    int fadePos_;
+    bool available_;
+    bool previousAvailable_;
+    bool held_;
+    bool choked_;
+    uint32_t startOrder_;
+
+    // Block buffers of render(): the envelope, and the outgoing voice
+    // during a transition
+    float envelopeOut_[AUDIO_BLOCK_SIZE];
+    float outgoing_[AUDIO_BLOCK_SIZE];
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include "Config.h"
+
+// Fixed arena that voices borrow their large state (delay lines) from while
+// they are active, instead of each voice embedding its own buffers.
+//
+// The storage is a plain member, so an arena with static storage duration
+// lives in .bss: nothing is zeroed element by element at boot, and a voice
+// clears only what it borrows, when it is activated. Blocks are placed
+// first-fit in offset order and can be returned in any order, so two
+// voices can hold memory at once. peak is the high-water mark of the used
+// region, which is what VOICE_ARENA_BYTES has to cover.
+//
+// Not thread-safe: borrow and return from the DSP task only.
+
+class VoiceArena {
+public:
+    static constexpr size_t kCapacity = static_cast<size_t>(VOICE_ARENA_BYTES);
+    static constexpr size_t kAlignment = 16;
+    static constexpr int kMaxBlocks = 8;
+
+    VoiceArena()
+        : blockCount_(0)
+        , used_(0)
+        , peak_(0)
+    {
+    }
+
+    VoiceArena(const VoiceArena&) = delete;
+    VoiceArena& operator=(const VoiceArena&) = delete;
+
+    // Returns nullptr when no gap is large enough or the block table is full
+    void* allocate(size_t bytes) {
+        if (bytes == 0 || blockCount_ == kMaxBlocks) return nullptr;
+        bytes = alignUp(bytes);
+
+        // First gap (between blocks, or after the last one) that fits
+        size_t offset = 0;
+        int slot = 0;
+        for (; slot < blockCount_; ++slot) {
+            if (blocks_[slot].offset - offset >= bytes) break;
+            offset = blocks_[slot].offset + blocks_[slot].size;
+        }
+        if (kCapacity - offset < bytes) return nullptr;
+
+        for (int i = blockCount_; i > slot; --i) {
+            blocks_[i] = blocks_[i - 1];
+        }
+        blocks_[slot] = Block{offset, bytes};
+        ++blockCount_;
+
+        used_ += bytes;
+        if (offset + bytes > peak_) peak_ = offset + bytes;
+        return storage_ + offset;
+    }
+
+    void release(void* ptr) {
+        if (!ptr) return;
+        size_t offset = static_cast<size_t>(static_cast<uint8_t*>(ptr) - storage_);
+        for (int slot = 0; slot < blockCount_; ++slot) {
+            if (blocks_[slot].offset != offset) continue;
+            used_ -= blocks_[slot].size;
+            --blockCount_;
+            for (int i = slot; i < blockCount_; ++i) {
+                blocks_[i] = blocks_[i + 1];
+            }
+            return;
+        }
+    }
+
+    // Construct a T in the arena. Default-initialized, so trivially
+    // constructible members (buffers) are left for the caller to clear.
+    template<typename T>
+    T* create() {
+        static_assert(alignof(T) <= kAlignment, "VoiceArena alignment too small");
+        void* memory = allocate(sizeof(T));
+        return memory ? new (memory) T : nullptr;
+    }
+
+    template<typename T>
+    void destroy(T*& object) {
+        if (!object) return;
+        object->~T();
+        release(object);
+        object = nullptr;
+    }
+
+    size_t getUsed() const {
+        return used_;
+    }
+
+    size_t getPeak() const {
+        return peak_;
+    }
+
+    size_t getCapacity() const {
+        return kCapacity;
+    }
+
+    // Size a type takes in the arena, for static sizing checks
+    template<typename T>
+    static constexpr size_t footprint() {
+        return alignUp(sizeof(T));
+    }
+
+private:
+    struct Block {
+        size_t offset;
+        size_t size;
+    };
+
+    static constexpr size_t alignUp(size_t bytes) {
+        return (bytes + kAlignment - 1) & ~(kAlignment - 1);
+    }
+
+    alignas(kAlignment) uint8_t storage_[kCapacity];
+    Block blocks_[kMaxBlocks];
+    int blockCount_;
+    size_t used_;
+    size_t peak_;
+};
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "Parameters.h"
+#include "ParamSmoother.h"
+#include "VoiceArena.h"
+
+// Compile-time voice registry
+//
+// A voice is any class with setFrequency(), trigger(), reset() and
+// processBlock(out, envelope, n), plus a VoiceTraits specialization that
+// describes it to the rest of the firmware: its wire ID, names, SHAPE menu
+// parameters and how a ParamMessage maps onto its setters. Voices that borrow
+// memory also provide acquire(VoiceArena&) / release(VoiceArena&); traits
+// with a render(voice, out, envelope, n, ParamRamps) hand the voice the
+// per-sample ramps of its moving controls.
+//
+// VoiceRegistry<Voices...> holds one instance of each listed voice and
+// dispatches to the selected one with a fold over the list, so a block
+// pays one small switch and the voice's own loop is fully static. A voice
+// left out of the list is not compiled at all; its VoiceType ID simply
+// has no voice behind it.
+
+struct VoiceInfo {
+    VoiceType type;
+    const char* name;       // Menu ("Orbit FM")
+    const char* tag;        // Debug log ("ORBIT")
+    const char* slug;       // Automation and golden files ("orbit")
+    const ParamId* shapeItems;  // SHAPE page, see ParamTable.h
+    int shapeItemCount;
+    bool triggerOnSelect;   // Re-excite when selected with the gate held
+};
+
+template<int N>
+constexpr VoiceInfo makeVoiceInfo(VoiceType type, const char* name, const char* tag, const char* slug,
+                                  const ParamId (&shapeItems)[N], bool triggerOnSelect = false) {
+    return VoiceInfo{type, name, tag, slug, shapeItems, N, triggerOnSelect};
+}
+
+template<typename Voice>
+struct VoiceTraits;
+
+namespace voice_registry_detail {
+
+template<typename Voice, typename = void>
+struct BorrowsMemory : std::false_type {};
+
+template<typename Voice>
+struct BorrowsMemory<Voice, std::void_t<decltype(std::declval<Voice&>().acquire(std::declval<VoiceArena&>()))>>
+    : std::true_type {};
+
+template<typename Voice, typename = void>
+struct TakesRamps : std::false_type {};
+
+template<typename Voice>
+struct TakesRamps<Voice, std::void_t<decltype(VoiceTraits<Voice>::render(
+    std::declval<Voice&>(), std::declval<float*>(), std::declval<const float*>(), 0,
+    std::declval<const ParamRamps&>()))>>
+    : std::true_type {};
+
+}  // namespace voice_registry_detail
+
+template<typename... Voices>
+class VoiceRegistry {
+public:
+    static constexpr int kCount = sizeof...(Voices);
+    static constexpr VoiceInfo kInfo[kCount] = {VoiceTraits<Voices>::kInfo...};
+
+    static_assert(kCount > 0, "VoiceRegistry needs at least one voice");
+
+    explicit VoiceRegistry(float sampleRate)
+        : voices_(((void)sizeof(Voices), sampleRate)...)
+    {
+    }
+
+    // Registry index of a voice ID, or -1 when that voice is not built in
+    static constexpr int indexOf(VoiceType type) {
+        for (int i = 0; i < kCount; ++i) {
+            if (kInfo[i].type == type) return i;
+        }
+        return -1;
+    }
+
+    static constexpr const VoiceInfo& info(int index) {
+        return kInfo[index];
+    }
+
+    template<typename Voice>
+    static constexpr bool contains() {
+        return (std::is_same<Voice, Voices>::value || ...);
+    }
+
+    template<typename Voice>
+    Voice& get() {
+        return std::get<Voice>(voices_);
+    }
+
+    template<typename Voice>
+    const Voice& get() const {
+        return std::get<Voice>(voices_);
+    }
+
+    // Call fn(voice) if Voice is registered; compiles to nothing otherwise
+    template<typename Voice, typename Fn>
+    void ifPresent(Fn&& fn) const {
+        if constexpr (contains<Voice>()) {
+            fn(std::get<Voice>(voices_));
+        }
+    }
+
+    // Call fn(voice) on every voice
+    template<typename Fn>
+    void forEach(Fn&& fn) {
+        std::apply([&fn](auto&... voice) { (fn(voice), ...); }, voices_);
+    }
+
+    // Call fn(voice) on the voice at `index`
+    template<typename Fn>
+    void visit(int index, Fn&& fn) {
+        visitImpl(index, fn, std::index_sequence_for<Voices...>{});
+    }
+
+    void applyParams(int index, const ParamMessage& params) {
+        visit(index, [&params](auto& voice) {
+            VoiceTraits<std::decay_t<decltype(voice)>>::apply(voice, params);
+        });
+    }
+
+    // Render the voice at `index`, from the ramps of the controls that are
+    // moving when its traits take them
+    void render(int index, float* out, const float* envelope, int numSamples, const ParamRamps& ramps) {
+        visit(index, [&](auto& voice) {
+            using Voice = std::decay_t<decltype(voice)>;
+            if constexpr (voice_registry_detail::TakesRamps<Voice>::value) {
+                VoiceTraits<Voice>::render(voice, out, envelope, numSamples, ramps);
+            } else {
+                voice.processBlock(out, envelope, numSamples);
+            }
+        });
+    }
+
+    // Borrow / return arena memory for the voice at `index`. Voices without
+    // large state need none and always succeed.
+    bool acquire(int index, VoiceArena& arena) {
+        bool ok = true;
+        visit(index, [&](auto& voice) {
+            if constexpr (voice_registry_detail::BorrowsMemory<std::decay_t<decltype(voice)>>::value) {
+                ok = voice.acquire(arena);
+            }
+        });
+        return ok;
+    }
+
+    void release(int index, VoiceArena& arena) {
+        visit(index, [&arena](auto& voice) {
+            if constexpr (voice_registry_detail::BorrowsMemory<std::decay_t<decltype(voice)>>::value) {
+                voice.release(arena);
+            }
+        });
+    }
+
+private:
+    template<typename Fn, size_t... I>
+    void visitImpl(int index, Fn& fn, std::index_sequence<I...>) {
+        (void)((index == static_cast<int>(I) ? (fn(std::get<I>(voices_)), true) : false) || ...);
+    }
+
+    std::tuple<Voices...> voices_;
+};
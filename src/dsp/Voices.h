@@ -0,0 +1,78 @@
+#pragma once
+
+#include "VoiceRegistry.h"
+#include "HarmonicCascade.h"
+#include "OrbitFm.h"
+#include "PitchedVerb.h"
+#include "Parameters.h"
+
+// Voice registrations
+//
+// Adding a voice: give it a VoiceType ID, write its VoiceTraits below and
+// list it in ClaudiusVoices. The engine, the menus, the debug log and the
+// host tools all pick it up from there.
+// Pot0/Pot1 are the voice's two timbre knobs; the SHAPE page edits the
+// rest of its controls. Controls that render() takes per sample follow
+// their smoothing ramps inside a block; the rest move once per block.
+
+template<>
+struct VoiceTraits<HarmonicCascade> {
+    static constexpr ParamId kShape[] = {ParamId::WAVEFOLD, ParamId::CHAOS};
+    static constexpr VoiceInfo kInfo =
+        makeVoiceInfo(VoiceType::CASCADE, "Cascade", "CASCADE", "cascade", kShape);
+
+    static void apply(HarmonicCascade& voice, const ParamMessage& params) {
+        voice.setSpread(params.pot0);
+        voice.setCascade(params.pot1);
+        voice.setWavefold(params.wavefold);
+        voice.setChaos(params.chaos);
+    }
+
+    static void render(HarmonicCascade& voice, float* out, const float* envelope, int numSamples,
+                       const ParamRamps& ramps) {
+        voice.processBlock(out, envelope, numSamples, ramps.get(ParamId::WAVEFOLD));
+    }
+};
+
+template<>
+struct VoiceTraits<OrbitFm> {
+    static constexpr ParamId kShape[] = {ParamId::FM_FEEDBACK, ParamId::FM_FOLD};
+    static constexpr VoiceInfo kInfo =
+        makeVoiceInfo(VoiceType::ORBIT_FM, "Orbit FM", "ORBIT", "orbit", kShape);
+
+    static void apply(OrbitFm& voice, const ParamMessage& params) {
+        voice.setIndex(params.pot0);
+        voice.setRatio(params.pot1);
+        voice.setFeedback(params.fmFeedback);
+        voice.setFold(params.fmFold);
+    }
+
+    static void render(OrbitFm& voice, float* out, const float* envelope, int numSamples, const ParamRamps& ramps) {
+        voice.processBlock(out, envelope, numSamples,
+            ramps.get(ParamId::POT0), ramps.get(ParamId::FM_FEEDBACK), ramps.get(ParamId::FM_FOLD));
+    }
+};
+
+template<>
+struct VoiceTraits<PitchedVerb> {
+    static constexpr ParamId kShape[] = {ParamId::VERB_MIX, ParamId::VERB_EXCITE, ParamId::VERB_MODE};
+    // The verb only sounds when excited, so selecting it with the gate held
+    // fires a new excitation
+    static constexpr VoiceInfo kInfo =
+        makeVoiceInfo(VoiceType::PITCH_VERB, "PitchVerb", "VERB", "verb", kShape, true);
+
+    static void apply(PitchedVerb& voice, const ParamMessage& params) {
+        voice.setFeedback(params.pot0);
+        voice.setDamp(params.pot1);
+        voice.setMix(params.verbMix);
+        voice.setExcite(params.verbExcite);
+        voice.setMode(static_cast<VerbMode>(params.verbMode));
+    }
+
+    static void render(PitchedVerb& voice, float* out, const float* envelope, int numSamples,
+                       const ParamRamps& ramps) {
+        voice.processBlock(out, envelope, numSamples, ramps.get(ParamId::VERB_MIX));
+    }
+};
+
+using ClaudiusVoices = VoiceRegistry<HarmonicCascade, OrbitFm, PitchedVerb>;
@@ -1,10 +1,36 @@
 #pragma once
 
+#include "AdcStream.h"
+
+// CV and pot inputs, sampled continuously in the background (AdcStream).
+// readCv0()..readPot2() return the newest filtered value of a knob channel;
+// readPitchCv() hands the DSP task every pitch CV sample since its last call.
+
+#if defined(ARDUINO)
+
 #include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include "PinConfig.h"
 
+// The ESP32's ADC DMA mode needs I2S0, which drives the built-in DAC here,
+// and two of the pots are on ADC2, so conversions are one-shot reads from a
+// sampler task. A hardware timer wakes it ADC_WAKE_RATE times a second and
+// it reads ADC_BURST ticks' worth back to back (~0.2 ms), rather than being
+// woken for every conversion. The task runs on the core that calls init()
+// (the UI core).
+
 class Adc {
 public:
+    Adc()
+        : samplerTask_(nullptr)
+        , wakeups_(0)
+    {
+        for (uint16_t& value : latest_) {
+            value = kMidScale;
+        }
+    }
+
     void init() {
         // Configure ADC resolution
         analogReadResolution(12);
@@ -12,32 +38,96 @@ public:
         analogSetAttenuation(ADC_11db);
 
         // Set pins as inputs
-        pinMode(PIN_CV0, INPUT);
-        pinMode(PIN_CV1, INPUT);
-        pinMode(PIN_CV2, INPUT);
-        pinMode(PIN_POT0, INPUT);
-        pinMode(PIN_POT1, INPUT);
-        pinMode(PIN_POT2, INPUT);
-
-        // Ensure pins are attached to ADC and have expected attenuation.
-        adcAttachPin(PIN_CV0);
-        adcAttachPin(PIN_CV1);
-        adcAttachPin(PIN_CV2);
-        adcAttachPin(PIN_POT0);
-        adcAttachPin(PIN_POT1);
-        adcAttachPin(PIN_POT2);
-        analogSetPinAttenuation(PIN_CV0, ADC_11db);
-        analogSetPinAttenuation(PIN_CV1, ADC_11db);
-        analogSetPinAttenuation(PIN_CV2, ADC_11db);
-        analogSetPinAttenuation(PIN_POT0, ADC_11db);
-        analogSetPinAttenuation(PIN_POT1, ADC_11db);
-        analogSetPinAttenuation(PIN_POT2, ADC_11db);
-    }
-
-    uint16_t readCv0()  { return analogRead(PIN_CV0); }
-    uint16_t readCv1()  { return analogRead(PIN_CV1); }
-    uint16_t readCv2()  { return analogRead(PIN_CV2); }
-    uint16_t readPot0() { return analogRead(PIN_POT0); }
-    uint16_t readPot1() { return analogRead(PIN_POT1); }
-    uint16_t readPot2() { return analogRead(PIN_POT2); }
+        for (int channel = 0; channel < AdcStream::kChannels; ++channel) {
+            int pin = pinFor(static_cast<AdcChannel>(channel));
+            pinMode(pin, INPUT);
+            // Ensure pins are attached to ADC and have expected attenuation.
+            adcAttachPin(pin);
+            analogSetPinAttenuation(pin, ADC_11db);
+        }
+
+        instance_ = this;
+        xTaskCreatePinnedToCore(samplerTask, "ADC", 2048, this, configMAX_PRIORITIES - 2,
+                                &samplerTask_, xPortGetCoreID());
+        hw_timer_t* timer = timerBegin(kTimerIndex, 80, true);  // 1 MHz
+        timerAttachInterrupt(timer, onTimer, true);
+        timerAlarmWrite(timer, 1000000 / ADC_WAKE_RATE, true);
+        timerAlarmEnable(timer);
+    }
+
+    uint16_t readCv0()  { return latest(AdcChannel::CV0); }
+    uint16_t readCv1()  { return latest(AdcChannel::CV1); }
+    uint16_t readPot0() { return latest(AdcChannel::POT0); }
+    uint16_t readPot1() { return latest(AdcChannel::POT1); }
+    uint16_t readPot2() { return latest(AdcChannel::POT2); }
+
+    int readPitchCv(uint16_t* out, int maxCount) {
+        return stream_.read(AdcChannel::CV2, out, maxCount);
+    }
+
+    uint32_t getDropped() const {
+        return stream_.getDropped();
+    }
+
+    // Sampler task wakeups since init(), for the UI core's wakeup rate
+    uint32_t getWakeups() const {
+        return wakeups_;
+    }
+
+private:
+    static_assert(ADC_SAMPLE_RATE % ADC_WAKE_RATE == 0, "ADC_SAMPLE_RATE must be a multiple of ADC_WAKE_RATE");
+
+    static constexpr uint8_t kTimerIndex = 0;
+    static constexpr uint16_t kMidScale = 2048;
+
+    static int pinFor(AdcChannel channel) {
+        switch (channel) {
+            case AdcChannel::CV0: return PIN_CV0;
+            case AdcChannel::CV1: return PIN_CV1;
+            case AdcChannel::CV2: return PIN_CV2;
+            case AdcChannel::POT0: return PIN_POT0;
+            case AdcChannel::POT1: return PIN_POT1;
+            default: return PIN_POT2;
+        }
+    }
+
+    static void IRAM_ATTR onTimer() {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(instance_->samplerTask_, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+
+    // A burst of ADC_BURST ticks per wakeup, each one pitch CV conversion
+    // and one knob conversion; wakeups missed while busy are skipped, not
+    // queued
+    static void samplerTask(void* arg) {
+        Adc* adc = static_cast<Adc*>(arg);
+        uint32_t tick = 0;
+        while (true) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            adc->wakeups_ = adc->wakeups_ + 1;
+            for (int i = 0; i < ADC_BURST; ++i) {
+                adc->stream_.push(AdcChannel::CV2, analogRead(PIN_CV2));
+                AdcChannel knob = AdcStream::knobChannel(tick++);
+                adc->stream_.push(knob, analogRead(pinFor(knob)));
+            }
+        }
+    }
+
+    uint16_t latest(AdcChannel channel) {
+        uint16_t& value = latest_[static_cast<int>(channel)];
+        stream_.readLatest(channel, value);
+        return value;
+    }
+
+    static inline Adc* instance_ = nullptr;
+
+    AdcStream stream_;
+    TaskHandle_t samplerTask_;
+    volatile uint32_t wakeups_;
+    uint16_t latest_[AdcStream::kChannels];  // Last value read, until a new one arrives
 };
+
+#else
+#include "host/HostAdc.h"
+#endif
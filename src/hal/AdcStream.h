@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include "Config.h"
+#include "EventQueue.h"
+
+// Continuous ADC acquisition, platform independent part.
+//
+// A sampler (a timer-paced task on the ESP32, the script on the host) feeds
+// raw 12-bit conversions in with push(); each channel runs them through a
+// CIC decimator and queues the filtered samples in its own ring. Readers
+// take either every sample since their last read (pitch CV, on the DSP
+// core) or just the newest (knobs, on the UI core). One producer and one
+// consumer per channel.
+
+enum class AdcChannel : uint8_t {
+    CV0 = 0,
+    CV1,
+    CV2,
+    POT0,
+    POT1,
+    POT2,
+    NUM_CHANNELS
+};
+
+// Second-order CIC decimator: `factor` raw samples in, one out. Unity gain
+// at DC, sinc^2 response, so it averages out converter noise and rejects
+// what would alias onto the output rate. Settles after two outputs.
+class CicDecimator {
+public:
+    explicit CicDecimator(int factor = 1)
+        : factor_(factor)
+        , gain_(static_cast<uint32_t>(factor * factor))
+        , phase_(0)
+        , integrator1_(0)
+        , integrator2_(0)
+        , comb1_(0)
+        , comb2_(0)
+    {
+    }
+
+    // Returns true and sets out once every `factor` inputs. The
+    // accumulators wrap; the combs undo it exactly.
+    bool push(uint16_t raw, uint16_t& out) {
+        integrator1_ += raw;
+        integrator2_ += integrator1_;
+        if (++phase_ < factor_) return false;
+        phase_ = 0;
+
+        uint32_t stage1 = integrator2_ - comb1_;
+        comb1_ = integrator2_;
+        uint32_t stage2 = stage1 - comb2_;
+        comb2_ = stage1;
+        out = static_cast<uint16_t>((stage2 + gain_ / 2) / gain_);
+        return true;
+    }
+
+private:
+    int factor_;
+    uint32_t gain_;
+    int phase_;
+    uint32_t integrator1_;
+    uint32_t integrator2_;
+    uint32_t comb1_;
+    uint32_t comb2_;
+};
+
+class AdcStream {
+public:
+    static constexpr int kChannels = static_cast<int>(AdcChannel::NUM_CHANNELS);
+    static constexpr int kKnobChannels = kChannels - 1;
+    static constexpr int kRingSize = 32;
+
+    AdcStream()
+        : dropped_(0)
+    {
+        for (int i = 0; i < kChannels; ++i) {
+            decimators_[i] = CicDecimator(oversample(static_cast<AdcChannel>(i)));
+        }
+    }
+
+    AdcStream(const AdcStream&) = delete;
+    AdcStream& operator=(const AdcStream&) = delete;
+
+    // Producer: one raw conversion of `channel`
+    void push(AdcChannel channel, uint16_t raw) {
+        int i = static_cast<int>(channel);
+        uint16_t filtered;
+        if (decimators_[i].push(raw, filtered) && !rings_[i].push(filtered)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Consumer: filtered samples since the last read, oldest first
+    int read(AdcChannel channel, uint16_t* out, int maxCount) {
+        EventQueue<uint16_t, kRingSize>& ring = rings_[static_cast<int>(channel)];
+        int count = 0;
+        while (count < maxCount && ring.peek(out[count])) {
+            ring.pop();
+            ++count;
+        }
+        return count;
+    }
+
+    // Consumer: newest filtered sample, dropping older ones; false when
+    // nothing arrived since the last read
+    bool readLatest(AdcChannel channel, uint16_t& value) {
+        EventQueue<uint16_t, kRingSize>& ring = rings_[static_cast<int>(channel)];
+        bool any = false;
+        while (ring.peek(value)) {
+            ring.pop();
+            any = true;
+        }
+        return any;
+    }
+
+    // Filtered samples lost to a full ring (a reader fell behind)
+    uint32_t getDropped() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    // Knob channel converted on sampler tick `tick`, alongside pitch CV
+    static AdcChannel knobChannel(uint32_t tick) {
+        static constexpr AdcChannel kOrder[kKnobChannels] = {
+            AdcChannel::CV0, AdcChannel::CV1, AdcChannel::POT0, AdcChannel::POT1, AdcChannel::POT2
+        };
+        return kOrder[tick % kKnobChannels];
+    }
+
+    static constexpr int oversample(AdcChannel channel) {
+        return channel == AdcChannel::CV2 ? ADC_CV_OVERSAMPLE : ADC_KNOB_OVERSAMPLE;
+    }
+
+    // Raw conversions per second of a channel
+    static constexpr float rawRate(AdcChannel channel) {
+        return channel == AdcChannel::CV2
+            ? static_cast<float>(ADC_SAMPLE_RATE)
+            : static_cast<float>(ADC_SAMPLE_RATE) / static_cast<float>(kKnobChannels);
+    }
+
+private:
+    CicDecimator decimators_[kChannels];
+    EventQueue<uint16_t, kRingSize> rings_[kChannels];
+    std::atomic<uint32_t> dropped_;
+};
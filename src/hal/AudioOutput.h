@@ -2,11 +2,48 @@
 
 #include <cstddef>
 #include <cstdint>
-#include <driver/i2s.h>
 #include "Config.h"
 
+// Convert float sample to DAC format
+// Input: -1.0 to 1.0
+// Output: 16-bit value for I2S DAC
+inline uint16_t floatToDacSample(float sample) {
+    // Clamp to valid range
+    if (sample < -1.0f) sample = -1.0f;
+    if (sample > 1.0f) sample = 1.0f;
+    // Convert to unsigned 16-bit (DAC expects unsigned)
+    // The internal DAC uses the upper 8 bits
+    float unipolar = (sample + 1.0f) * 0.5f;
+    return static_cast<uint16_t>(unipolar * 65535.0f);
+}
+
+#if defined(ARDUINO)
+
+#include <Arduino.h>
+#include <driver/i2s.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+// The driver raises a TX_DONE event for every DMA buffer (one block) it
+// has sent. write() counts blocks in and events out; when more went out
+// than were written, the DMA ran dry and played cleared buffers, which is
+// counted as underruns. A stall long enough to fill the event queue makes
+// the driver drop its oldest events; then the buffers sent are taken from
+// the time since the last count instead (the DMA sends one per block
+// period, cleared or not), and the blocks in flight are clamped to what
+// the DMA holds, so lost events cannot hide later underruns.
+
 class AudioOutput {
 public:
+    AudioOutput()
+        : events_(nullptr)
+        , queued_(0)
+        , started_(false)
+        , lastCountUs_(0)
+        , underruns_(0)
+    {
+    }
+
     bool init() {
         i2s_config_t config{};
         config.mode = static_cast<i2s_mode_t>(I2S_MODE_MASTER | I2S_MODE_TX | I2S_MODE_DAC_BUILT_IN);
@@ -15,13 +52,13 @@ public:
         config.channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT;
         config.communication_format = I2S_COMM_FORMAT_STAND_MSB;
         config.intr_alloc_flags = 0;
-        config.dma_buf_count = 8;
+        config.dma_buf_count = kDmaBufCount;
         config.dma_buf_len = AUDIO_BLOCK_SIZE;
         config.use_apll = false;
         config.tx_desc_auto_clear = true;
         config.fixed_mclk = 0;
 
-        if (i2s_driver_install(I2S_NUM_0, &config, 0, nullptr) != ESP_OK) {
+        if (i2s_driver_install(I2S_NUM_0, &config, kEventQueueLength, &events_) != ESP_OK) {
             return false;
         }
 
@@ -39,20 +76,64 @@ public:
     // Write a buffer of samples
     // buffer: array of 16-bit samples (interleaved L/R for stereo)
     // length: size in bytes
+    // Blocks while the DMA queue is full, which paces the DSP loop
     bool write(const uint16_t* buffer, size_t length, size_t* bytesWritten) {
-        return i2s_write(I2S_NUM_0, buffer, length, bytesWritten, portMAX_DELAY) == ESP_OK;
+        countSentBuffers();
+        bool ok = i2s_write(I2S_NUM_0, buffer, length, bytesWritten, portMAX_DELAY) == ESP_OK;
+        queued_ += static_cast<int>(*bytesWritten / kDmaBufBytes);
+        started_ = true;
+        return ok;
+    }
+
+    uint32_t getUnderruns() const {
+        return underruns_;
     }
 
-    // Convert float sample to DAC format
-    // Input: -1.0 to 1.0
-    // Output: 16-bit value for I2S DAC
     static uint16_t floatToSample(float sample) {
-        // Clamp to valid range
-        if (sample < -1.0f) sample = -1.0f;
-        if (sample > 1.0f) sample = 1.0f;
-        // Convert to unsigned 16-bit (DAC expects unsigned)
-        // The internal DAC uses the upper 8 bits
-        float unipolar = (sample + 1.0f) * 0.5f;
-        return static_cast<uint16_t>(unipolar * 65535.0f);
+        return floatToDacSample(sample);
     }
+
+private:
+    static constexpr int kDmaBufCount = 8;
+    static constexpr size_t kDmaBufBytes = AUDIO_BLOCK_SIZE * 2 * sizeof(uint16_t);
+    // Events pile up while write() blocks; a couple of blocks' worth
+    static constexpr int kEventQueueLength = 2 * kDmaBufCount;
+
+    void countSentBuffers() {
+        bool overflowed = uxQueueMessagesWaiting(events_) >= static_cast<UBaseType_t>(kEventQueueLength);
+        int sent = 0;
+        i2s_event_t event;
+        while (xQueueReceive(events_, &event, 0) == pdTRUE) {
+            if (event.type == I2S_EVENT_TX_DONE) ++sent;
+        }
+
+        uint32_t now = micros();
+        if (overflowed) {
+            float periods = static_cast<float>(now - lastCountUs_) * SAMPLE_RATE / (1.0e6f * AUDIO_BLOCK_SIZE);
+            int elapsed = static_cast<int>(periods + 0.5f);
+            if (elapsed > sent) sent = elapsed;
+        }
+        lastCountUs_ = now;
+
+        for (; sent > 0; --sent) {
+            if (queued_ > 0) {
+                --queued_;
+            } else if (started_) {
+                underruns_++;
+            }
+        }
+        if (queued_ > kDmaBufCount) {
+            queued_ = kDmaBufCount;
+        }
+    }
+
+    QueueHandle_t events_;
+    int queued_;      // Blocks written and not yet sent
+    bool started_;    // Before the first write the DMA sends silence by design
+    uint32_t lastCountUs_;
+    uint32_t underruns_;
 };
+
+#else
+#include "host/HostAudioOutput.h"
+#endif
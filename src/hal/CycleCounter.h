@@ -0,0 +1,28 @@
+#pragma once
+
+// Free-running cycle counter for profiling DSP code.
+// ESP32: the CPU's CCOUNT register (240 MHz, wraps every ~18 s).
+// Host: see host/HostCycleCounter.h.
+
+#if defined(ARDUINO)
+
+#include <Arduino.h>
+
+namespace platform {
+
+using CycleCount = uint32_t;
+
+inline CycleCount cycleCount() {
+    return ESP.getCycleCount();
+}
+
+// Counter ticks per second
+inline CycleCount cycleRate() {
+    return static_cast<CycleCount>(ESP.getCpuFreqMHz()) * 1000000u;
+}
+
+}  // namespace platform
+
+#else
+#include "host/HostCycleCounter.h"
+#endif
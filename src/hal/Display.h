@@ -1,41 +1,40 @@
 #pragma once
 
+#if defined(ARDUINO)
+
 #include <Wire.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_SH110X.h>
 #include "PinConfig.h"
+#include "PageDiff.h"
 
 class Display {
 public:
     bool init() {
         Wire.begin(PIN_SDA, PIN_SCL);
-        if (!display_.begin(0x3C, true)) {
+        if (!display_.begin(kAddress, true)) {
             return false;
         }
+        // The library drops the bus clock after its own transfers; frames
+        // here are sent by update()
+        Wire.setClock(PageDiff::kBusHz);
         display_.clearDisplay();
         display_.setTextSize(1);
         display_.setTextColor(SH110X_WHITE);
-        display_.display();
+        transfer_.invalidate();
+        update();
+        flush();
         return true;
     }
 
-    void clear() {
-        display_.clearDisplay();
-    }
-
-    void showTitle(const char* title) {
-        display_.setTextSize(2);
-        display_.setCursor(10, 0);
-        display_.print(title);
-        display_.setTextSize(1);
-    }
-
+    // Draws over whatever the row held before
     void showMenuLine(const char* text, int row, bool selected) {
-        int y = row * 10;
+        int y = row * kRowHeight;
         if (selected) {
-            display_.fillRect(0, y, 128, 10, SH110X_WHITE);
+            display_.fillRect(0, y, kWidth, kRowHeight, SH110X_WHITE);
             display_.setTextColor(SH110X_BLACK);
         } else {
+            clearMenuLine(row);
             display_.setTextColor(SH110X_WHITE);
         }
         display_.setCursor(2, y + 1);
@@ -43,34 +42,106 @@ public:
         display_.setTextColor(SH110X_WHITE);
     }
 
-    void showStatus(float freq, float level, bool playing) {
-        char buf[32];
+    void clearMenuLine(int row) {
+        display_.fillRect(0, row * kRowHeight, kWidth, kRowHeight, SH110X_BLACK);
+    }
+
+    // Status line at the bottom (y=56), one field at a time
 
-        // Status line at bottom (y=56)
-        // Show playing indicator
+    void showPlaying(bool playing) {
+        display_.fillRect(kPlayingX, kStatusY, kPlayingWidth, kStatusHeight, SH110X_BLACK);
         if (playing) {
             display_.fillCircle(6, 60, 3, SH110X_WHITE);
         } else {
             display_.drawCircle(6, 60, 3, SH110X_WHITE);
         }
+    }
 
-        // Show level bar
-        int barWidth = static_cast<int>(level * 36.0f);
+    // Level bar fill in pixels, the resolution the status line can show
+    static int levelBarWidth(float level) {
+        int width = static_cast<int>(level * 36.0f);
+        return width < 0 ? 0 : (width > 36 ? 36 : width);
+    }
+
+    void showLevel(int barWidth) {
+        display_.fillRect(kLevelX, kStatusY, kLevelWidth, kStatusHeight, SH110X_BLACK);
         display_.drawRect(14, 57, 38, 6, SH110X_WHITE);
         if (barWidth > 0) {
             display_.fillRect(15, 58, barWidth, 4, SH110X_WHITE);
         }
+    }
 
-        // Show frequency
-        snprintf(buf, sizeof(buf), "%.0fHz", freq);
+    void showFrequency(int freq) {
+        char buf[16];
+        display_.fillRect(kFreqX, kStatusY, kWidth - kFreqX, kStatusHeight, SH110X_BLACK);
+        snprintf(buf, sizeof(buf), "%dHz", freq);
         display_.setCursor(56, 56);
         display_.print(buf);
     }
 
+    // Start sending the pages that changed since the last update, each
+    // from its first to its last changed column. Nothing goes on the bus
+    // here; sendNext() moves the frame a chunk at a time. Don't draw until
+    // isIdle(); a frame still in flight is flushed first.
     void update() {
-        display_.display();
+        flush();
+        stats_.addFrame(transfer_.start(display_.getBuffer()));
+    }
+
+    // Send the next chunk of the frame in flight (at most ~1.6 ms of bus
+    // time); returns the bytes sent, 0 when idle
+    int sendNext() {
+        PageChunk chunk;
+        if (!transfer_.next(chunk)) return 0;
+        const uint8_t* data = display_.getBuffer() + chunk.page * kWidth + chunk.column;
+        if (chunk.address) {
+            int column = chunk.column + kColumnOffset;
+            Wire.beginTransmission(kAddress);
+            Wire.write(0x00);  // Command stream
+            Wire.write(static_cast<uint8_t>(0xB0 | chunk.page));
+            Wire.write(static_cast<uint8_t>(0x10 | (column >> 4)));
+            Wire.write(static_cast<uint8_t>(column & 0x0F));
+            Wire.endTransmission();
+        }
+        Wire.beginTransmission(kAddress);
+        Wire.write(0x40);  // Data stream
+        Wire.write(data, chunk.length);
+        Wire.endTransmission();
+        stats_.addChunk(chunk.bytes());
+        return chunk.bytes();
+    }
+
+    void flush() {
+        while (sendNext() > 0) {
+        }
+    }
+
+    bool isIdle() const {
+        return transfer_.isIdle();
+    }
+
+    const DisplayStats& getStats() const {
+        return stats_;
     }
 
 private:
+    static constexpr int kWidth = 128;
+    static constexpr int kRowHeight = 10;
+    static constexpr int kStatusY = 56;
+    static constexpr int kStatusHeight = 8;
+    static constexpr int kPlayingX = 0;
+    static constexpr int kPlayingWidth = 12;
+    static constexpr int kLevelX = 12;
+    static constexpr int kLevelWidth = 42;
+    static constexpr int kFreqX = 54;
+    static constexpr uint8_t kAddress = 0x3C;
+    static constexpr int kColumnOffset = 2;  // 128 visible of the SH1106's 132 columns
+
     Adafruit_SH1106G display_{128, 64, &Wire};
+    PageTransfer transfer_;
+    DisplayStats stats_;
 };
+
+#else
+#include "host/HostDisplay.h"
+#endif
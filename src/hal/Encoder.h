@@ -1,76 +1,60 @@
 #pragma once
 
+#include "QuadratureDecoder.h"
+
+// Rotary encoder with push button. Rotation is decoded in pin-change
+// interrupts and accumulated in atomic counters, so nothing is lost while
+// the UI loop is busy; readMotion() collects what happened since the last
+// call. Each detent and press also notifies the task that called init(), so
+// the UI can sleep until there is input.
+
+#if defined(ARDUINO)
+
+#include <atomic>
 #include <Arduino.h>
 #include "PinConfig.h"
 #include "Config.h"
+#include "Platform.h"
 
 class Encoder {
 public:
+    Encoder()
+        : task_(nullptr)
+        , lastPressUs_(0)
+        , detents_(0)
+        , accelerated_(0)
+        , presses_(0)
+    {
+    }
+
+    // Attaches the interrupts to the calling core and task
     void init() {
+        task_ = platform::currentTask();
         pinMode(PIN_ENC_CLK, INPUT_PULLUP);
         pinMode(PIN_ENC_DT, INPUT_PULLUP);
         pinMode(PIN_ENC_SW, INPUT_PULLUP);
 
-        // Read initial state
-        lastState_ = (digitalRead(PIN_ENC_CLK) << 1) | digitalRead(PIN_ENC_DT);
-        lastSw_ = HIGH;
-        accumulator_ = 0;
+        attachInterruptArg(digitalPinToInterrupt(PIN_ENC_CLK), onTurn, this, CHANGE);
+        attachInterruptArg(digitalPinToInterrupt(PIN_ENC_DT), onTurn, this, CHANGE);
+        attachInterruptArg(digitalPinToInterrupt(PIN_ENC_SW), onPress, this, FALLING);
     }
 
-    // Returns rotation delta: -1, 0, or +1
-    int8_t readRotation() {
-        // Read current state of both pins
-        int clk = digitalRead(PIN_ENC_CLK);
-        int dt = digitalRead(PIN_ENC_DT);
-        int state = (clk << 1) | dt;
-
-        // Gray code state machine
-        // Valid transitions: 00->01->11->10->00 (CW) or 00->10->11->01->00 (CCW)
-        if (state != lastState_) {
-            // Debounce: only accept if enough time has passed
-            unsigned long now = millis();
-            if (now - lastRotTime_ >= 2) {  // 2ms minimum between transitions
-                // Determine direction from state transition (swapped for correct direction)
-                int transition = (lastState_ << 2) | state;
-                switch (transition) {
-                    case 0b0001: case 0b0111: case 0b1110: case 0b1000:
-                        accumulator_--;  // Was ++, swapped
-                        break;
-                    case 0b0010: case 0b1011: case 0b1101: case 0b0100:
-                        accumulator_++;  // Was --, swapped
-                        break;
-                }
-                lastRotTime_ = now;
-            }
-            lastState_ = state;
-        }
-
-        // Return accumulated clicks (detent = 4 state changes for slower response)
-        int8_t delta = 0;
-        if (accumulator_ >= 4) {
-            delta = 1;
-            accumulator_ -= 4;
-        } else if (accumulator_ <= -4) {
-            delta = -1;
-            accumulator_ += 4;
-        }
-        return delta;
+    EncoderMotion readMotion() {
+        EncoderMotion motion;
+        motion.detents = detents_.exchange(0, std::memory_order_relaxed);
+        motion.accelerated = accelerated_.exchange(0, std::memory_order_relaxed);
+        return motion;
     }
 
-    // Returns true if button was just pressed
+    // Returns true once per press
     bool readButtonPress() {
-        int sw = digitalRead(PIN_ENC_SW);
-        bool pressed = false;
-
-        if (sw == LOW && lastSw_ == HIGH) {
-            unsigned long now = millis();
-            if (now - lastSwTime_ >= 50) {  // 50ms debounce for button
-                pressed = true;
-                lastSwTime_ = now;
+        int pending = presses_.load(std::memory_order_relaxed);
+        while (pending > 0) {
+            if (presses_.compare_exchange_weak(pending, pending - 1, std::memory_order_relaxed)) {
+                return true;
             }
         }
-        lastSw_ = sw;
-        return pressed;
+        return false;
     }
 
     // Returns true if button is currently held
@@ -79,9 +63,41 @@ public:
     }
 
 private:
-    int lastState_ = 0;
-    int lastSw_ = HIGH;
-    int accumulator_ = 0;
-    unsigned long lastRotTime_ = 0;
-    unsigned long lastSwTime_ = 0;
+    static constexpr uint32_t kPressDebounceUs = 50000;
+
+    static void IRAM_ATTR onTurn(void* arg) {
+        Encoder* encoder = static_cast<Encoder*>(arg);
+        uint8_t pins = static_cast<uint8_t>((digitalRead(PIN_ENC_CLK) << 1) | digitalRead(PIN_ENC_DT));
+        int direction = encoder->decoder_.update(pins);
+        if (direction == 0) return;
+        int weight = encoder->acceleration_.weigh(static_cast<uint32_t>(micros()));
+        encoder->detents_.fetch_add(direction, std::memory_order_relaxed);
+        encoder->accelerated_.fetch_add(direction * weight, std::memory_order_relaxed);
+        platform::notifyFromIsr(encoder->task_);
+    }
+
+    static void IRAM_ATTR onPress(void* arg) {
+        Encoder* encoder = static_cast<Encoder*>(arg);
+        uint32_t now = static_cast<uint32_t>(micros());
+        if (now - encoder->lastPressUs_ < kPressDebounceUs) return;
+        encoder->lastPressUs_ = now;
+        encoder->presses_.fetch_add(1, std::memory_order_relaxed);
+        platform::notifyFromIsr(encoder->task_);
+    }
+
+    platform::TaskHandle task_;
+
+    // Interrupt only
+    QuadratureDecoder decoder_;
+    EncoderAcceleration acceleration_;
+    uint32_t lastPressUs_;
+
+    // Interrupt to UI task
+    std::atomic<int> detents_;
+    std::atomic<int> accelerated_;
+    std::atomic<int> presses_;
 };
+
+#else
+#include "host/HostEncoder.h"
+#endif
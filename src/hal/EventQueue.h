@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Wait-free single-producer, single-consumer ring (gate edges from an
+// interrupt handler, ADC samples from the sampler task).
+//
+// push() fails rather than overwriting when the ring is full, so the
+// consumer never sees events out of order; the caller counts the drop.
+// The consumer can look at the oldest event and leave it for later.
+
+template<typename T, int N>
+class EventQueue {
+public:
+    static_assert(N > 1 && (N & (N - 1)) == 0, "EventQueue size must be a power of two");
+
+    EventQueue()
+        : head_(0)
+        , tail_(0)
+    {
+    }
+
+    EventQueue(const EventQueue&) = delete;
+    EventQueue& operator=(const EventQueue&) = delete;
+
+    // Producer
+    bool push(const T& event) {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == static_cast<uint32_t>(N)) return false;
+        events_[head & kMask] = event;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: copy the oldest event, leaving it queued
+    bool peek(T& event) const {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (head_.load(std::memory_order_acquire) == tail) return false;
+        event = events_[tail & kMask];
+        return true;
+    }
+
+    // Consumer: drop the oldest event (after a successful peek)
+    void pop() {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+private:
+    static constexpr uint32_t kMask = static_cast<uint32_t>(N - 1);
+
+    T events_[N];
+    std::atomic<uint32_t> head_;  // Producer only writes
+    std::atomic<uint32_t> tail_;  // Consumer only writes
+};
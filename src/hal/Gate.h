@@ -1,22 +1,67 @@
 #pragma once
 
+#include "GateEdge.h"
+
+// Gate input and output. Input edges are timestamped where they happen and
+// queued for the DSP task, which places each one on its exact sample
+// (see DspTask); readGateIn() gives the current level.
+
+#if defined(ARDUINO)
+
 #include <Arduino.h>
 #include "PinConfig.h"
 
 class Gate {
 public:
+    Gate()
+        : dropped_(0)
+    {
+    }
+
+    // Attaches the edge interrupt to the calling core
     void init() {
         pinMode(PIN_GATE_IN, INPUT);
         pinMode(PIN_GATE_OUT, OUTPUT);
         digitalWrite(PIN_GATE_OUT, LOW);
+        attachInterruptArg(digitalPinToInterrupt(PIN_GATE_IN), onEdge, this, CHANGE);
     }
 
     bool readGateIn() {
         return digitalRead(PIN_GATE_IN) == HIGH;
     }
 
+    // Oldest queued edge; leave it queued until popEdge()
+    bool peekEdge(GateEdge& edge) const {
+        return edges_.peek(edge);
+    }
+
+    void popEdge() {
+        edges_.pop();
+    }
+
+    // Edges lost to a full queue
+    uint32_t getDroppedEdges() const {
+        return dropped_;
+    }
+
     void setGateOut(bool active) {
         // Inverted: LOW when playing (typical for eurorack)
         digitalWrite(PIN_GATE_OUT, active ? LOW : HIGH);
     }
+
+private:
+    static void IRAM_ATTR onEdge(void* arg) {
+        Gate* gate = static_cast<Gate*>(arg);
+        GateEdge edge{static_cast<uint32_t>(micros()), digitalRead(PIN_GATE_IN) == HIGH};
+        if (!gate->edges_.push(edge)) {
+            gate->dropped_ = gate->dropped_ + 1;
+        }
+    }
+
+    GateEdgeQueue edges_;
+    volatile uint32_t dropped_;
 };
+
+#else
+#include "host/HostGate.h"
+#endif
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+#include "EventQueue.h"
+
+// A gate input transition, stamped with platform::micros() when it happened
+struct GateEdge {
+    uint32_t micros;
+    bool high;
+};
+
+// Edges buffered between two DSP blocks; a 1.45 ms block holds far fewer
+using GateEdgeQueue = EventQueue<GateEdge, 16>;
@@ -0,0 +1,33 @@
+#pragma once
+
+// Single-slot, latest-value mailbox between the UI and DSP cores.
+// overwrite() replaces any unread value; receive() never blocks.
+
+#if defined(ARDUINO)
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+template<typename T>
+class Mailbox {
+public:
+    bool create() {
+        handle_ = xQueueCreate(1, sizeof(T));
+        return handle_ != nullptr;
+    }
+
+    void overwrite(const T& value) {
+        xQueueOverwrite(handle_, &value);
+    }
+
+    bool receive(T& value) {
+        return xQueueReceive(handle_, &value, 0) == pdTRUE;
+    }
+
+private:
+    QueueHandle_t handle_ = nullptr;
+};
+
+#else
+#include "host/HostMailbox.h"
+#endif
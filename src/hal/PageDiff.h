@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// Change tracking between a 128x64 framebuffer in SH1106 page layout (8
+// pages of 128 bytes, LSB = top row) and what the panel shows.
+//
+// diff() compares the frame against its copy of the panel and returns, for
+// every page that changed, the span of columns from the first to the last
+// changed byte. Only those bytes need to go over I2C; the copy is updated as
+// if they were sent. PageTransfer hands the spans out in bus-sized chunks,
+// so the UI loop can send a frame a piece per tick. Platform independent so
+// the host display and the device share it.
+
+struct PageSpan {
+    uint8_t page;
+    uint8_t first;  // First changed column
+    uint8_t last;   // Last changed column, inclusive
+};
+
+// Bytes on the bus per frame and per chunk (I2C address and control bytes
+// included)
+struct DisplayStats {
+    uint32_t frames = 0;
+    uint32_t bytes = 0;
+    uint32_t lastFrameBytes = 0;
+    uint32_t peakFrameBytes = 0;
+    uint32_t peakChunkBytes = 0;
+
+    void addFrame(uint32_t frameBytes) {
+        frames++;
+        bytes += frameBytes;
+        lastFrameBytes = frameBytes;
+        if (frameBytes > peakFrameBytes) peakFrameBytes = frameBytes;
+    }
+
+    void addChunk(uint32_t chunkBytes) {
+        if (chunkBytes > peakChunkBytes) peakChunkBytes = chunkBytes;
+    }
+
+    float avgFrameBytes() const {
+        return frames > 0 ? static_cast<float>(bytes) / static_cast<float>(frames) : 0.0f;
+    }
+};
+
+class PageDiff {
+public:
+    static constexpr int kWidth = 128;
+    static constexpr int kPages = 8;
+    static constexpr int kBufferBytes = kWidth * kPages;
+
+    // Per span: one command transaction (address, control, page and two
+    // column commands), then data transactions of up to kChunkBytes, each
+    // with an address and a control byte
+    static constexpr int kCommandBytes = 5;
+    static constexpr int kChunkBytes = 64;
+    static constexpr int kChunkOverheadBytes = 2;
+
+    // 400 kHz, 9 clocks per byte with the ACK
+    static constexpr uint32_t kBusHz = 400000;
+
+    static uint32_t busMicros(uint32_t bytes) {
+        return static_cast<uint32_t>(static_cast<uint64_t>(bytes) * 9 * 1000000 / kBusHz);
+    }
+
+    PageDiff()
+        : valid_(false)
+    {
+        std::memset(shown_, 0, sizeof(shown_));
+    }
+
+    // Panel contents unknown (after init or a reset): the next diff covers
+    // every page in full
+    void invalidate() {
+        valid_ = false;
+    }
+
+    // Fill spans (room for kPages) with what changed; returns the count
+    int diff(const uint8_t* frame, PageSpan* spans) {
+        int count = 0;
+        for (int page = 0; page < kPages; ++page) {
+            const uint8_t* next = frame + page * kWidth;
+            uint8_t* shown = shown_ + page * kWidth;
+            int first = 0;
+            int last = kWidth - 1;
+            if (valid_) {
+                while (first < kWidth && next[first] == shown[first]) ++first;
+                if (first == kWidth) continue;
+                while (next[last] == shown[last]) --last;
+            }
+            std::memcpy(shown + first, next + first, static_cast<size_t>(last + 1 - first));
+            spans[count++] = {static_cast<uint8_t>(page), static_cast<uint8_t>(first), static_cast<uint8_t>(last)};
+        }
+        valid_ = true;
+        return count;
+    }
+
+    static int spanBytes(const PageSpan& span) {
+        int data = span.last + 1 - span.first;
+        int chunks = (data + kChunkBytes - 1) / kChunkBytes;
+        return kCommandBytes + chunks * kChunkOverheadBytes + data;
+    }
+
+private:
+    uint8_t shown_[kBufferBytes];
+    bool valid_;
+};
+
+// One bus step of a transfer: the page/column address when a span starts,
+// then up to kChunkBytes of data from the frame
+struct PageChunk {
+    uint8_t page;
+    uint8_t column;
+    uint8_t length;
+    bool address;
+
+    int bytes() const {
+        return (address ? PageDiff::kCommandBytes : 0) + PageDiff::kChunkOverheadBytes + length;
+    }
+};
+
+// A frame on its way to the panel. start() diffs it and queues the changed
+// spans; next() returns them chunk by chunk. The frame must not change until
+// the transfer is idle again.
+class PageTransfer {
+public:
+    PageTransfer()
+        : count_(0)
+        , index_(0)
+        , column_(0)
+    {
+    }
+
+    void invalidate() {
+        diff_.invalidate();
+    }
+
+    // Queue what changed in frame; returns the bytes it will take on the bus
+    uint32_t start(const uint8_t* frame) {
+        count_ = diff_.diff(frame, spans_);
+        index_ = 0;
+        column_ = count_ > 0 ? spans_[0].first : 0;
+        uint32_t bytes = 0;
+        for (int i = 0; i < count_; ++i) {
+            bytes += static_cast<uint32_t>(PageDiff::spanBytes(spans_[i]));
+        }
+        return bytes;
+    }
+
+    bool next(PageChunk& chunk) {
+        if (isIdle()) return false;
+        const PageSpan& span = spans_[index_];
+        int length = span.last + 1 - column_;
+        if (length > PageDiff::kChunkBytes) length = PageDiff::kChunkBytes;
+        chunk.page = span.page;
+        chunk.column = static_cast<uint8_t>(column_);
+        chunk.length = static_cast<uint8_t>(length);
+        chunk.address = column_ == span.first;
+
+        column_ += length;
+        if (column_ > span.last && ++index_ < count_) {
+            column_ = spans_[index_].first;
+        }
+        return true;
+    }
+
+    bool isIdle() const {
+        return index_ >= count_;
+    }
+
+private:
+    PageDiff diff_;
+    PageSpan spans_[PageDiff::kPages];
+    int count_;
+    int index_;
+    int column_;  // Next column to send in spans_[index_]
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+// Platform services used by the task loops: time, task delay, task
+// notifications and logging.
+// On the ESP32 these map straight onto Arduino/FreeRTOS; host builds run the
+// same task code as std::threads against a virtual clock (see host/).
+
+#if defined(ARDUINO)
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+namespace platform {
+
+inline uint32_t millis() {
+    return ::millis();
+}
+
+// Safe to call from interrupt handlers
+inline uint32_t micros() {
+    return ::micros();
+}
+
+using TaskHandle = TaskHandle_t;
+
+inline TaskHandle currentTask() {
+    return xTaskGetCurrentTaskHandle();
+}
+
+// Wake `task` out of waitNotify(); interrupt handlers only
+inline void IRAM_ATTR notifyFromIsr(TaskHandle task) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(task, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+// Sleep for up to `ms` or until notified; returns whether a notification
+// arrived. Rounded up to whole RTOS ticks, so a job is never woken before
+// its deadline to find nothing due; pdMS_TO_TICKS would round down, to 0
+// for waits under one tick at CONFIG_FREERTOS_HZ=100.
+inline bool waitNotify(uint32_t ms) {
+    TickType_t ticks = static_cast<TickType_t>(
+        (static_cast<uint64_t>(ms) * configTICK_RATE_HZ + 999) / 1000);
+    return ulTaskNotifyTake(pdTRUE, ticks) > 0;
+}
+
+// Task loops run forever on the device
+constexpr bool keepRunning() {
+    return true;
+}
+
+template<typename... Args>
+inline void log(const char* format, Args... args) {
+    Serial.printf(format, args...);
+}
+
+}  // namespace platform
+
+#else
+#include "host/HostPlatform.h"
+#endif
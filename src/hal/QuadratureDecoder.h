@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+
+// Table-driven quadrature decoding for a detented rotary encoder.
+//
+// Each pin change steps a state machine on the 2-bit pin state (CLK << 1 |
+// DT); a detent counts only once the full gray-code cycle back to the rest
+// state (both high) has been seen in order. Contact bounce walks back and
+// forth between neighbouring states and never completes a cycle, so no
+// time-based debounce is needed and no transition is thrown away.
+//
+// EncoderAcceleration scales each detent by how soon it followed the
+// previous one, so a fast spin covers a whole range and a slow turn stays
+// fine-grained.
+
+class QuadratureDecoder {
+public:
+    QuadratureDecoder()
+        : state_(kStart)
+    {
+    }
+
+    // Feed the current pin state; returns +1 (CLK leads) or -1 (DT leads)
+    // when a detent completes, otherwise 0
+    int update(uint8_t pins) {
+        state_ = kTable[state_ & kStateMask][pins & 0x3];
+        if (state_ & kClockwise) return 1;
+        if (state_ & kCounterClockwise) return -1;
+        return 0;
+    }
+
+private:
+    enum : uint8_t {
+        kStart = 0x0,
+        kCwFinal = 0x1,
+        kCwBegin = 0x2,
+        kCwNext = 0x3,
+        kCcwBegin = 0x4,
+        kCcwFinal = 0x5,
+        kCcwNext = 0x6,
+        kStateMask = 0x0f,
+        kClockwise = 0x10,
+        kCounterClockwise = 0x20,
+    };
+
+    // Next state for [state][pins]
+    static constexpr uint8_t kTable[7][4] = {
+        {kStart,   kCwBegin,  kCcwBegin, kStart},                      // kStart
+        {kCwNext,  kStart,    kCwFinal,  kStart | kClockwise},         // kCwFinal
+        {kCwNext,  kCwBegin,  kStart,    kStart},                      // kCwBegin
+        {kCwNext,  kCwBegin,  kCwFinal,  kStart},                      // kCwNext
+        {kCcwNext, kStart,    kCcwBegin, kStart},                      // kCcwBegin
+        {kCcwNext, kCcwFinal, kStart,    kStart | kCounterClockwise},  // kCcwFinal
+        {kCcwNext, kCcwFinal, kCcwBegin, kStart},                      // kCcwNext
+    };
+
+    uint8_t state_;
+};
+
+class EncoderAcceleration {
+public:
+    EncoderAcceleration()
+        : lastDetentUs_(0)
+        , hasLast_(false)
+    {
+    }
+
+    // Weight of a detent at nowUs: 1 when turned slowly, up to kMaxFactor
+    // when detents come faster than kSlowUs / kMaxFactor apart
+    int weigh(uint32_t nowUs) {
+        uint32_t interval = nowUs - lastDetentUs_;
+        bool first = !hasLast_;
+        lastDetentUs_ = nowUs;
+        hasLast_ = true;
+        if (first || interval >= kSlowUs) return 1;
+        uint32_t factor = kSlowUs / (interval > 0 ? interval : 1);
+        return factor > kMaxFactor ? kMaxFactor : static_cast<int>(factor);
+    }
+
+private:
+    static constexpr uint32_t kSlowUs = 40000;  // Slower than 25 detents/s: no acceleration
+    static constexpr int kMaxFactor = 5;
+
+    uint32_t lastDetentUs_;
+    bool hasLast_;
+};
+
+// Detents turned since the last read: as counted, and weighted by speed
+struct EncoderMotion {
+    int detents;
+    int accelerated;
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#if !defined(ARDUINO)
+#include <functional>
+#endif
+
+// Wait-free latest-value snapshot from one writer to one reader (UI core to
+// DSP core).
+//
+// Three slots: the writer owns one, the reader owns one and the third is
+// the latest publication. publish() fills the writer's slot and swaps it
+// with the middle one; read() swaps its slot with the middle one if that
+// holds something new. Each side does one atomic exchange and never waits
+// or retries, so neither core can stall the other, and a reader never sees
+// a half-written value. Values published between two reads are skipped.
+//
+// Every publication carries a generation number, so the reader can tell
+// how many updates it coalesced and skip work when nothing arrived.
+//
+// Exactly one thread may call publish() and one other thread read().
+
+template<typename T>
+class TripleBuffer {
+public:
+    TripleBuffer()
+        : state_(kMiddleInit)
+        , writeIndex_(kWriteInit)
+        , readIndex_(kReadInit)
+        , generation_(0)
+    {
+        for (Slot& slot : slots_) {
+            slot.value = T{};
+            slot.generation = 0;
+        }
+    }
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Writer: make value the latest snapshot
+    void publish(const T& value) {
+        Slot& slot = slots_[writeIndex_];
+        slot.value = value;
+        slot.generation = ++generation_;
+        uint32_t previous = state_.exchange(writeIndex_ | kFresh, std::memory_order_acq_rel);
+        writeIndex_ = previous & kIndexMask;
+    }
+
+    // Reader: copy the latest snapshot into value if one arrived since the
+    // last read. O(1); returns false and leaves value alone otherwise.
+    bool read(T& value) {
+        if (!(state_.load(std::memory_order_relaxed) & kFresh)) return false;
+        uint32_t previous = state_.exchange(readIndex_, std::memory_order_acq_rel);
+        readIndex_ = previous & kIndexMask;
+        value = slots_[readIndex_].value;
+#if !defined(ARDUINO)
+        if (observer_) observer_(value);
+#endif
+        return true;
+    }
+
+    // Reader: generation of the last snapshot read (0 before the first)
+    uint32_t getReadGeneration() const {
+        return slots_[readIndex_].generation;
+    }
+
+    // Writer: generation of the last publication
+    uint32_t getWriteGeneration() const {
+        return generation_;
+    }
+
+#if !defined(ARDUINO)
+    // Host builds: lets the simulator timestamp when the reader picks a
+    // value up. Set before the tasks start.
+    void setReadObserver(std::function<void(const T&)> observer) {
+        observer_ = std::move(observer);
+    }
+#endif
+
+private:
+    static constexpr uint32_t kIndexMask = 0x3;
+    static constexpr uint32_t kFresh = 0x4;
+    static constexpr uint32_t kWriteInit = 0;
+    static constexpr uint32_t kMiddleInit = 1;
+    static constexpr uint32_t kReadInit = 2;
+
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "TripleBuffer needs lock-free 32-bit atomics");
+
+    struct Slot {
+        T value;
+        uint32_t generation;
+    };
+
+    Slot slots_[3];
+    std::atomic<uint32_t> state_;  // Middle slot index | kFresh
+    uint32_t writeIndex_;          // Writer only
+    uint32_t readIndex_;           // Reader only
+    uint32_t generation_;          // Writer only
+#if !defined(ARDUINO)
+    std::function<void(const T&)> observer_;
+#endif
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include "Config.h"
+#include "../AdcStream.h"
+#include "SimClock.h"
+#include "SimInputs.h"
+
+// The script's raw 12-bit levels stand in for the converter. Before each
+// read, a channel gets every conversion the ESP32 sampler would have made
+// since the last one, in whole bursts, so the filtered stream has the same
+// rate and delay as on the device.
+
+class Adc {
+public:
+    Adc() {
+        for (int i = 0; i < AdcStream::kChannels; ++i) {
+            converted_[i] = 0;
+            latest_[i] = kMidScale;
+        }
+    }
+
+    void init() {
+    }
+
+    uint16_t readCv0()  { return latest(AdcChannel::CV0); }
+    uint16_t readCv1()  { return latest(AdcChannel::CV1); }
+    uint16_t readPot0() { return latest(AdcChannel::POT0); }
+    uint16_t readPot1() { return latest(AdcChannel::POT1); }
+    uint16_t readPot2() { return latest(AdcChannel::POT2); }
+
+    int readPitchCv(uint16_t* out, int maxCount) {
+        catchUp(AdcChannel::CV2);
+        int count = stream_.read(AdcChannel::CV2, out, maxCount);
+        if (count > 0 && pitchCvObserver_) pitchCvObserver_(out[count - 1]);
+        return count;
+    }
+
+    // Lets the simulator timestamp when the DSP task takes pitch CV
+    // samples (called with the newest). Set before the tasks start.
+    void setPitchCvObserver(std::function<void(uint16_t)> observer) {
+        pitchCvObserver_ = std::move(observer);
+    }
+
+    uint32_t getDropped() const {
+        return stream_.getDropped();
+    }
+
+    // Wakeups the ESP32 sampler task would have had by now
+    uint32_t getWakeups() const {
+        return static_cast<uint32_t>(simClock().nowFrames() * ADC_WAKE_RATE / static_cast<uint64_t>(SAMPLE_RATE));
+    }
+
+private:
+    static_assert(static_cast<int>(AdcChannel::POT2) == SimInputs::POT2, "ADC channel order out of sync");
+
+    static constexpr uint16_t kMidScale = 2048;
+
+    // A reader that slept longer than the ring covers only needs the tail
+    static constexpr uint64_t kMaxCatchUp =
+        static_cast<uint64_t>(AdcStream::kRingSize) * (ADC_CV_OVERSAMPLE > ADC_KNOB_OVERSAMPLE
+                                                       ? ADC_CV_OVERSAMPLE : ADC_KNOB_OVERSAMPLE);
+
+    // Runs on the channel's reader thread, so each channel still has one
+    // producer and one consumer
+    void catchUp(AdcChannel channel) {
+        int i = static_cast<int>(channel);
+        double rate = AdcStream::rawRate(channel);
+        uint64_t ticks = static_cast<uint64_t>(getWakeups()) * ADC_BURST;
+        uint64_t due = static_cast<uint64_t>(static_cast<double>(ticks) * rate / ADC_SAMPLE_RATE);
+        uint64_t& done = converted_[i];
+        if (due > done + kMaxCatchUp) done = due - kMaxCatchUp;
+        uint16_t raw = simInputs().raw[i].load(std::memory_order_relaxed);
+        for (; done < due; ++done) {
+            stream_.push(channel, raw);
+        }
+    }
+
+    uint16_t latest(AdcChannel channel) {
+        catchUp(channel);
+        uint16_t& value = latest_[static_cast<int>(channel)];
+        stream_.readLatest(channel, value);
+        return value;
+    }
+
+    AdcStream stream_;
+    uint64_t converted_[AdcStream::kChannels];
+    uint16_t latest_[AdcStream::kChannels];
+    std::function<void(uint16_t)> pitchCvObserver_;
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include "Config.h"
+#include "SimClock.h"
+
+// Host audio sink. Models the I2S DMA queue (8 buffers of one block, as in
+// the ESP32 driver config) against simClock(): write() blocks while the
+// queue is full, and an underrun is counted whenever the queue ran dry
+// before the next block arrived (only possible in REALTIME mode).
+
+struct HostAudioStats {
+    std::atomic<uint64_t> blocks{0};
+    std::atomic<uint64_t> renderNs{0};
+    std::atomic<uint64_t> maxRenderNs{0};
+    std::atomic<uint64_t> deadlineMisses{0};
+    std::atomic<uint32_t> underruns{0};
+    std::atomic<int64_t> minQueuedFrames{-1};
+    std::atomic<uint64_t> queuedFrames{0};
+
+    // Receives the left channel as float, e.g. a WavWriter; may be empty
+    std::function<void(const float*, int)> sink;
+};
+
+inline HostAudioStats& hostAudio() {
+    static HostAudioStats stats;
+    return stats;
+}
+
+class AudioOutput {
+public:
+    static constexpr int kDmaBufCount = 8;
+    static constexpr uint64_t kDmaFrames = kDmaBufCount * AUDIO_BLOCK_SIZE;
+
+    bool init() {
+        written_ = 0;
+        lastReturn_ = SimClock::WallClock::now();
+        return true;
+    }
+
+    bool write(const uint16_t* buffer, size_t length, size_t* bytesWritten) {
+        using namespace std::chrono;
+        HostAudioStats& stats = hostAudio();
+        SimClock& clock = simClock();
+        const int frames = static_cast<int>(length / (2 * sizeof(uint16_t)));
+
+        // Wall time since the previous write returned is the block's render time
+        uint64_t renderNs = static_cast<uint64_t>(
+            duration_cast<nanoseconds>(SimClock::WallClock::now() - lastReturn_).count());
+        const uint64_t budgetNs = static_cast<uint64_t>(1.0e9 * frames / clock.sampleRate());
+        stats.blocks++;
+        stats.renderNs += renderNs;
+        if (renderNs > stats.maxRenderNs) stats.maxRenderNs = renderNs;
+        if (renderNs > budgetNs) stats.deadlineMisses++;
+
+        uint64_t now = clock.nowFrames();
+        if (written_ < now) {
+            // DMA ran dry: the DAC repeated/zeroed samples until now
+            if (written_ > 0) stats.underruns++;
+            written_ = now;
+        }
+
+        // Block while the DMA queue is full, like portMAX_DELAY on the device
+        if (written_ + frames > now + kDmaFrames) {
+            if (!clock.waitUntil(written_ + frames - kDmaFrames)) {
+                *bytesWritten = 0;
+                return false;
+            }
+            now = clock.nowFrames();
+        }
+
+        // Queue depth once the initial fill is done
+        int64_t queued = static_cast<int64_t>(written_ > now ? written_ - now : 0);
+        if (written_ >= kDmaFrames
+            && (stats.minQueuedFrames < 0 || queued < stats.minQueuedFrames)) {
+            stats.minQueuedFrames = queued;
+        }
+
+        if (stats.sink) {
+            float samples[AUDIO_BLOCK_SIZE];
+            int done = 0;
+            while (done < frames) {
+                int chunk = frames - done < AUDIO_BLOCK_SIZE ? frames - done : AUDIO_BLOCK_SIZE;
+                for (int i = 0; i < chunk; ++i) {
+                    samples[i] = static_cast<float>(buffer[(done + i) * 2]) / 32767.5f - 1.0f;
+                }
+                stats.sink(samples, chunk);
+                done += chunk;
+            }
+        }
+
+        written_ += static_cast<uint64_t>(frames);
+        stats.queuedFrames = written_ - now;
+        *bytesWritten = length;
+        lastReturn_ = SimClock::WallClock::now();
+        return true;
+    }
+
+    uint32_t getUnderruns() const {
+        return hostAudio().underruns;
+    }
+
+    static uint16_t floatToSample(float sample) {
+        return floatToDacSample(sample);
+    }
+
+private:
+    uint64_t written_ = 0;
+    SimClock::WallClock::time_point lastReturn_;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Host cycle counter: the TSC on x86 (reference cycles, not scaled by
+// turbo), nanoseconds from steady_clock elsewhere.
+
+namespace platform {
+
+using CycleCount = uint64_t;
+
+inline CycleCount cycleCount() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<CycleCount>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Counter ticks per second. The TSC rate is measured once against
+// steady_clock, over 10 ms on first use.
+inline CycleCount cycleRate() {
+#if defined(__x86_64__) || defined(__i386__)
+    static const CycleCount rate = [] {
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point start = Clock::now();
+        CycleCount startCycles = __rdtsc();
+        Clock::time_point now = start;
+        while (now - start < std::chrono::milliseconds(10)) {
+            now = Clock::now();
+        }
+        CycleCount cycles = __rdtsc() - startCycles;
+        double seconds = std::chrono::duration<double>(now - start).count();
+        return static_cast<CycleCount>(static_cast<double>(cycles) / seconds);
+    }();
+    return rate;
+#else
+    return 1000000000u;
+#endif
+}
+
+}  // namespace platform
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include "Font5x7.h"
+#include "../PageDiff.h"
+
+// In-memory SH1106 128x64 display for host builds.
+// The framebuffer uses the controller's page layout (8 pages of 128 bytes,
+// LSB = top row). update() and sendNext() copy to the panel only the chunks
+// PageTransfer hands out, as the device sends them over I2C, so a screenshot
+// shows what an incremental transfer would leave on the OLED.
+
+struct HostDisplayState {
+    static constexpr int kWidth = 128;
+    static constexpr int kHeight = 64;
+    static constexpr int kPages = kHeight / 8;
+    static constexpr int kBufferBytes = kWidth * kPages;
+
+    std::mutex mutex;
+    uint8_t panel[kBufferBytes] = {};  // what the OLED currently shows
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> bytesSent{0};
+    std::atomic<uint32_t> peakFrameBytes{0};
+    std::atomic<uint32_t> peakChunkBytes{0};
+
+    // Write the panel contents as a plain PBM image
+    bool savePbm(const char* path) {
+        std::FILE* file = std::fopen(path, "w");
+        if (!file) return false;
+        std::lock_guard<std::mutex> lock(mutex);
+        std::fprintf(file, "P1\n%d %d\n", kWidth, kHeight);
+        for (int y = 0; y < kHeight; ++y) {
+            for (int x = 0; x < kWidth; ++x) {
+                int bit = (panel[(y / 8) * kWidth + x] >> (y & 7)) & 1;
+                std::fputc(bit ? '1' : '0', file);
+            }
+            std::fputc('\n', file);
+        }
+        return std::fclose(file) == 0;
+    }
+};
+
+inline HostDisplayState& hostDisplay() {
+    static HostDisplayState state;
+    return state;
+}
+
+class Display {
+public:
+    static constexpr int kWidth = HostDisplayState::kWidth;
+    static constexpr int kHeight = HostDisplayState::kHeight;
+    static constexpr uint8_t WHITE = 1;
+    static constexpr uint8_t BLACK = 0;
+
+    bool init() {
+        std::memset(buffer_, 0, sizeof(buffer_));
+        transfer_.invalidate();
+        update();
+        flush();
+        return true;
+    }
+
+    // Draws over whatever the row held before
+    void showMenuLine(const char* text, int row, bool selected) {
+        int y = row * kRowHeight;
+        uint8_t color = WHITE;
+        if (selected) {
+            fillRect(0, y, kWidth, kRowHeight, WHITE);
+            color = BLACK;
+        } else {
+            clearMenuLine(row);
+        }
+        drawText(2, y + 1, text, color, 1);
+    }
+
+    void clearMenuLine(int row) {
+        fillRect(0, row * kRowHeight, kWidth, kRowHeight, BLACK);
+    }
+
+    // Status line at the bottom (y=56), one field at a time
+
+    void showPlaying(bool playing) {
+        fillRect(kPlayingX, kStatusY, kPlayingWidth, kStatusHeight, BLACK);
+        if (playing) {
+            fillCircle(6, 60, 3, WHITE);
+        } else {
+            drawCircle(6, 60, 3, WHITE);
+        }
+    }
+
+    // Level bar fill in pixels, the resolution the status line can show
+    static int levelBarWidth(float level) {
+        int width = static_cast<int>(level * 36.0f);
+        return width < 0 ? 0 : (width > 36 ? 36 : width);
+    }
+
+    void showLevel(int barWidth) {
+        fillRect(kLevelX, kStatusY, kLevelWidth, kStatusHeight, BLACK);
+        drawRect(14, 57, 38, 6, WHITE);
+        if (barWidth > 0) {
+            fillRect(15, 58, barWidth, 4, WHITE);
+        }
+    }
+
+    void showFrequency(int freq) {
+        char buf[16];
+        fillRect(kFreqX, kStatusY, kWidth - kFreqX, kStatusHeight, BLACK);
+        snprintf(buf, sizeof(buf), "%dHz", freq);
+        drawText(56, 56, buf, WHITE, 1);
+    }
+
+    // Start a frame: queue what changed since the last update. Don't draw
+    // until isIdle(); a frame still in flight is flushed first.
+    void update() {
+        flush();
+        uint32_t frameBytes = transfer_.start(buffer_);
+        stats_.addFrame(frameBytes);
+        HostDisplayState& state = hostDisplay();
+        state.frames++;
+        if (frameBytes > state.peakFrameBytes) state.peakFrameBytes = frameBytes;
+    }
+
+    // Copy the next chunk to the panel; returns its bytes on the bus
+    int sendNext() {
+        PageChunk chunk;
+        if (!transfer_.next(chunk)) return 0;
+        HostDisplayState& state = hostDisplay();
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            int offset = chunk.page * kWidth + chunk.column;
+            std::memcpy(state.panel + offset, buffer_ + offset, chunk.length);
+        }
+        uint32_t bytes = static_cast<uint32_t>(chunk.bytes());
+        stats_.addChunk(bytes);
+        state.bytesSent += bytes;
+        if (bytes > state.peakChunkBytes) state.peakChunkBytes = bytes;
+        return chunk.bytes();
+    }
+
+    void flush() {
+        while (sendNext() > 0) {
+        }
+    }
+
+    bool isIdle() const {
+        return transfer_.isIdle();
+    }
+
+    const DisplayStats& getStats() const {
+        return stats_;
+    }
+
+    const uint8_t* buffer() const {
+        return buffer_;
+    }
+
+private:
+    static constexpr int kRowHeight = 10;
+    static constexpr int kStatusY = 56;
+    static constexpr int kStatusHeight = 8;
+    static constexpr int kPlayingX = 0;
+    static constexpr int kPlayingWidth = 12;
+    static constexpr int kLevelX = 12;
+    static constexpr int kLevelWidth = 42;
+    static constexpr int kFreqX = 54;
+
+    void drawPixel(int x, int y, uint8_t color) {
+        if (x < 0 || x >= kWidth || y < 0 || y >= kHeight) return;
+        uint8_t& byte = buffer_[(y / 8) * kWidth + x];
+        uint8_t mask = static_cast<uint8_t>(1u << (y & 7));
+        byte = color ? (byte | mask) : (byte & ~mask);
+    }
+
+    void fillRect(int x, int y, int w, int h, uint8_t color) {
+        for (int j = y; j < y + h; ++j) {
+            for (int i = x; i < x + w; ++i) {
+                drawPixel(i, j, color);
+            }
+        }
+    }
+
+    void drawRect(int x, int y, int w, int h, uint8_t color) {
+        for (int i = x; i < x + w; ++i) {
+            drawPixel(i, y, color);
+            drawPixel(i, y + h - 1, color);
+        }
+        for (int j = y; j < y + h; ++j) {
+            drawPixel(x, j, color);
+            drawPixel(x + w - 1, j, color);
+        }
+    }
+
+    void drawCircle(int cx, int cy, int r, uint8_t color) {
+        int x = r;
+        int y = 0;
+        int err = 1 - r;
+        while (x >= y) {
+            drawPixel(cx + x, cy + y, color); drawPixel(cx - x, cy + y, color);
+            drawPixel(cx + x, cy - y, color); drawPixel(cx - x, cy - y, color);
+            drawPixel(cx + y, cy + x, color); drawPixel(cx - y, cy + x, color);
+            drawPixel(cx + y, cy - x, color); drawPixel(cx - y, cy - x, color);
+            ++y;
+            if (err < 0) {
+                err += 2 * y + 1;
+            } else {
+                --x;
+                err += 2 * (y - x) + 1;
+            }
+        }
+    }
+
+    void fillCircle(int cx, int cy, int r, uint8_t color) {
+        for (int dy = -r; dy <= r; ++dy) {
+            for (int dx = -r; dx <= r; ++dx) {
+                if (dx * dx + dy * dy <= r * r + r) {
+                    drawPixel(cx + dx, cy + dy, color);
+                }
+            }
+        }
+    }
+
+    // GFX-style text: 5x7 glyph in a 6x8 cell, transparent background
+    void drawText(int x, int y, const char* text, uint8_t color, int size) {
+        for (const char* c = text; *c; ++c) {
+            uint8_t ch = static_cast<uint8_t>(*c);
+            if (ch < kFont5x7First || ch > kFont5x7Last) ch = '?';
+            const uint8_t* glyph = kFont5x7[ch - kFont5x7First];
+            for (int col = 0; col < 5; ++col) {
+                for (int row = 0; row < 7; ++row) {
+                    if (glyph[col] & (1u << row)) {
+                        fillRect(x + col * size, y + row * size, size, size, color);
+                    }
+                }
+            }
+            x += 6 * size;
+        }
+    }
+
+    uint8_t buffer_[HostDisplayState::kBufferBytes] = {};
+    PageTransfer transfer_;
+    DisplayStats stats_;
+};
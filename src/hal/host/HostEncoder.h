@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include "../QuadratureDecoder.h"
+#include "SimInputs.h"
+#include "HostPlatform.h"
+
+// Scripted encoder: hands out every queued detent at once, like the
+// interrupt-fed counters on the device. Scripted turns count as slow ones
+// (no acceleration). The script notifies the task that called init().
+
+class Encoder {
+public:
+    void init() {
+        simInputs().encoderTask = platform::currentTask();
+    }
+
+    EncoderMotion readMotion() {
+        int detents = simInputs().encoderSteps.exchange(0);
+        return EncoderMotion{detents, detents};
+    }
+
+    bool readButtonPress() {
+        std::atomic<int>& presses = simInputs().buttonPresses;
+        int pending = presses.load();
+        while (pending > 0) {
+            if (presses.compare_exchange_weak(pending, pending - 1)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool isButtonHeld() {
+        return simInputs().buttonHeld.load();
+    }
+};
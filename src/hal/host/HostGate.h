@@ -0,0 +1,34 @@
+#pragma once
+
+#include "../GateEdge.h"
+#include "SimInputs.h"
+
+// The simulator's input script stands in for the edge interrupt: it queues
+// a timestamped edge whenever it changes the gate level.
+
+class Gate {
+public:
+    void init() {
+        simInputs().gateOut = false;
+    }
+
+    bool readGateIn() {
+        return simInputs().gateIn.load(std::memory_order_relaxed);
+    }
+
+    bool peekEdge(GateEdge& edge) const {
+        return simInputs().gateEdges.peek(edge);
+    }
+
+    void popEdge() {
+        simInputs().gateEdges.pop();
+    }
+
+    uint32_t getDroppedEdges() const {
+        return simInputs().droppedGateEdges.load(std::memory_order_relaxed);
+    }
+
+    void setGateOut(bool active) {
+        simInputs().gateOut.store(active, std::memory_order_relaxed);
+    }
+};
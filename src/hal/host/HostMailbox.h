@@ -0,0 +1,46 @@
+#pragma once
+
+#include <functional>
+#include <mutex>
+
+// Host stand-in for the FreeRTOS single-slot queue.
+// The optional receive observer lets the simulator timestamp when the DSP
+// side actually picks a value up.
+
+template<typename T>
+class Mailbox {
+public:
+    bool create() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        full_ = false;
+        return true;
+    }
+
+    void overwrite(const T& value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        value_ = value;
+        full_ = true;
+    }
+
+    bool receive(T& value) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!full_) return false;
+            value = value_;
+            full_ = false;
+        }
+        if (observer_) observer_(value);
+        return true;
+    }
+
+    // Set before the tasks start
+    void setReceiveObserver(std::function<void(const T&)> observer) {
+        observer_ = std::move(observer);
+    }
+
+private:
+    std::mutex mutex_;
+    T value_{};
+    bool full_ = false;
+    std::function<void(const T&)> observer_;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include "SimClock.h"
+
+// Host implementation of the platform services, driven by simClock().
+// One FreeRTOS tick is 1 ms, as configured on the ESP32.
+
+namespace platform {
+
+inline uint32_t millis() {
+    return simClock().millis();
+}
+
+inline uint32_t micros() {
+    return simClock().micros();
+}
+
+// Task notifications: one slot per simulated task
+using TaskHandle = SimWake*;
+
+inline TaskHandle currentTask() {
+    constexpr int kMaxTasks = 8;
+    static SimWake slots[kMaxTasks];
+    static std::atomic<int> next{0};
+    static thread_local SimWake* slot = &slots[next++ % kMaxTasks];
+    return slot;
+}
+
+inline void notifyFromIsr(TaskHandle task) {
+    simClock().notify(*task);
+}
+
+inline bool waitNotify(uint32_t ms) {
+    SimClock& clock = simClock();
+    TaskHandle task = currentTask();
+    uint32_t wakeMs = clock.millis() + ms;
+    clock.waitUntil(clock.framesForMs(wakeMs), task);
+    return clock.takeNotification(*task);
+}
+
+inline bool keepRunning() {
+    return !simClock().stopping();
+}
+
+inline bool& logEnabled() {
+    static bool enabled = true;
+    return enabled;
+}
+
+inline void log(const char* format, ...) {
+    if (!logEnabled()) return;
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::fprintf(stderr, "[%8u] ", millis());
+    va_list args;
+    va_start(args, format);
+    std::vfprintf(stderr, format, args);
+    va_end(args);
+}
+
+}  // namespace platform
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <thread>
+#include "Config.h"
+
+// Per-task busy time between sleeps, measured in wall-clock nanoseconds
+struct TaskStats {
+    uint64_t iterations = 0;
+    uint64_t busyNs = 0;
+    uint64_t maxBusyNs = 0;
+
+    void add(uint64_t ns) {
+        iterations++;
+        busyNs += ns;
+        if (ns > maxBusyNs) maxBusyNs = ns;
+    }
+
+    double avgBusyUs() const {
+        return iterations ? static_cast<double>(busyNs) / iterations / 1000.0 : 0.0;
+    }
+};
+
+// A task's notification slot (FreeRTOS direct-to-task notification): set by
+// SimClock::notify(), it ends the task's current waitUntil() early. Only
+// SimClock touches the fields, under its lock.
+struct SimWake {
+    bool pending = false;
+    bool waiting = false;
+};
+
+// Clock shared by the simulated tasks, counted in audio frames.
+//
+// VIRTUAL: discrete-event time. Every participating thread sleeps through
+// waitUntil(); time only moves when all of them are waiting, and then jumps
+// to the earliest deadline. Work takes zero virtual time, so runs are
+// repeatable and faster than realtime.
+// REALTIME: time follows the wall clock, waitUntil() really sleeps. Used to
+// find underruns and deadline misses of the real task loops on this host.
+
+class SimClock {
+public:
+    enum class Mode : uint8_t {
+        VIRTUAL,
+        REALTIME
+    };
+
+    using WallClock = std::chrono::steady_clock;
+
+    void configure(Mode mode, float sampleRate = SAMPLE_RATE) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        mode_ = mode;
+        sampleRate_ = sampleRate;
+        now_ = 0;
+        stopping_ = false;
+        start_ = WallClock::now();
+    }
+
+    Mode mode() const {
+        return mode_;
+    }
+
+    float sampleRate() const {
+        return sampleRate_;
+    }
+
+    // Threads that sleep on the clock must be counted before the clock starts
+    void addParticipant() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        participants_++;
+    }
+
+    void removeParticipant() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        participants_--;
+        advanceIfIdle();
+    }
+
+    uint64_t nowFrames() {
+        if (mode_ == Mode::REALTIME) {
+            return wallFrames();
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        return now_;
+    }
+
+    uint32_t millis() {
+        return static_cast<uint32_t>(nowFrames() * 1000 / static_cast<uint64_t>(sampleRate_));
+    }
+
+    uint32_t micros() {
+        return static_cast<uint32_t>(nowFrames() * 1000000 / static_cast<uint64_t>(sampleRate_));
+    }
+
+    // First frame at which millis() reads `ms`
+    uint64_t framesForMs(uint32_t ms) const {
+        return (static_cast<uint64_t>(ms) * static_cast<uint64_t>(sampleRate_) + 999) / 1000;
+    }
+
+    // Sleep until `frame`, or until `wake` is notified if given. Returns
+    // false once the simulation is stopping.
+    bool waitUntil(uint64_t frame, SimWake* wake = nullptr) {
+        markBusyEnd();
+        bool running = (mode_ == Mode::REALTIME) ? waitRealtime(frame, wake) : waitVirtual(frame, wake);
+        markBusyStart();
+        return running;
+    }
+
+    // Wake the task sleeping on `wake`, or make its next wait return at once.
+    // In virtual time the task counts as running from here, so the clock
+    // does not move on before it has had its turn.
+    void notify(SimWake& wake) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wake.pending = true;
+        if (wake.waiting) {
+            wake.waiting = false;
+            waiting_--;
+        }
+        cv_.notify_all();
+    }
+
+    // Clear and return the notification, like ulTaskNotifyTake()
+    bool takeNotification(SimWake& wake) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bool pending = wake.pending;
+        wake.pending = false;
+        return pending;
+    }
+
+    void stop() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        cv_.notify_all();
+    }
+
+    bool stopping() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stopping_;
+    }
+
+    // Attribute the calling thread's busy time to `stats` (nullptr to stop)
+    static void bindTaskStats(TaskStats* stats) {
+        currentStats() = stats;
+        busyStart() = WallClock::now();
+    }
+
+private:
+    uint64_t wallFrames() const {
+        double seconds = std::chrono::duration<double>(WallClock::now() - start_).count();
+        return static_cast<uint64_t>(seconds * sampleRate_);
+    }
+
+    bool waitRealtime(uint64_t frame, SimWake* wake) {
+        auto target = start_ + std::chrono::duration_cast<WallClock::duration>(
+            std::chrono::duration<double>(static_cast<double>(frame) / sampleRate_));
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_until(lock, target, [&] { return stopping_ || (wake && wake->pending); });
+        return !stopping_;
+    }
+
+    bool waitVirtual(uint64_t frame, SimWake* wake) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (stopping_) return false;
+        if (frame <= now_ || (wake && wake->pending)) return true;
+
+        auto deadline = deadlines_.insert(frame);
+        waiting_++;
+        if (wake) wake->waiting = true;
+        advanceIfIdle();
+        cv_.wait(lock, [&] { return now_ >= frame || stopping_ || (wake && wake->pending); });
+        // notify() has already counted a woken task as running
+        if (!wake || wake->waiting) waiting_--;
+        if (wake) wake->waiting = false;
+        deadlines_.erase(deadline);
+        return !stopping_;
+    }
+
+    // Caller holds mutex_
+    void advanceIfIdle() {
+        if (waiting_ >= participants_ && !deadlines_.empty()) {
+            now_ = std::max(now_, *deadlines_.begin());
+            cv_.notify_all();
+        }
+    }
+
+    static TaskStats*& currentStats() {
+        static thread_local TaskStats* stats = nullptr;
+        return stats;
+    }
+
+    static WallClock::time_point& busyStart() {
+        static thread_local WallClock::time_point start;
+        return start;
+    }
+
+    static void markBusyEnd() {
+        if (TaskStats* stats = currentStats()) {
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                WallClock::now() - busyStart()).count();
+            stats->add(static_cast<uint64_t>(ns));
+        }
+    }
+
+    static void markBusyStart() {
+        busyStart() = WallClock::now();
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::multiset<uint64_t> deadlines_;
+    Mode mode_ = Mode::VIRTUAL;
+    float sampleRate_ = SAMPLE_RATE;
+    uint64_t now_ = 0;
+    int participants_ = 0;
+    int waiting_ = 0;
+    bool stopping_ = false;
+    WallClock::time_point start_ = WallClock::now();
+};
+
+inline SimClock& simClock() {
+    static SimClock clock;
+    return clock;
+}
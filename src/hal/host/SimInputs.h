@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include "../GateEdge.h"
+#include "SimClock.h"
+
+// Front-panel state for host builds, written by the simulator's input
+// script and read by the host Adc/Gate/Encoder backends.
+
+struct SimInputs {
+    enum Channel : uint8_t {
+        CV0 = 0,
+        CV1,
+        CV2,
+        POT0,
+        POT1,
+        POT2,
+        NUM_CHANNELS
+    };
+
+    std::atomic<uint16_t> raw[NUM_CHANNELS];
+    std::atomic<bool> gateIn{false};
+    std::atomic<bool> gateOut{false};
+    GateEdgeQueue gateEdges;            // script to DSP, like the edge interrupt
+    std::atomic<uint32_t> droppedGateEdges{0};
+    std::atomic<int> encoderSteps{0};   // pending detents, signed
+    std::atomic<int> buttonPresses{0};  // pending presses
+    std::atomic<bool> buttonHeld{false};
+    std::atomic<SimWake*> encoderTask{nullptr};  // notified on turns and presses
+
+    SimInputs() {
+        for (auto& value : raw) {
+            value.store(2048);
+        }
+    }
+};
+
+inline SimInputs& simInputs() {
+    static SimInputs inputs;
+    return inputs;
+}
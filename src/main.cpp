@@ -2,7 +2,7 @@
 // A Eurorack voice module for ESP32
 //
 // Features:
-// - Harmonic cascade synthesis with up to 8 harmonics
+// - Harmonic cascade synthesis with up to 32 harmonics
 // - Higher harmonics decay faster for evolving timbres
 // - Wave folding for additional harmonic content
 // - Chaos modulation for organic movement
@@ -18,11 +18,17 @@
 
 #include "Parameters.h"
 #include "dsp/DspTask.h"
+#include "hal/Adc.h"
+#include "hal/Mailbox.h"
+#include "hal/TripleBuffer.h"
 #include "ui/UiTask.h"
 
-// Inter-core communication queues
-QueueHandle_t gParamQueue = nullptr;
-QueueHandle_t gStatusQueue = nullptr;
+// Inter-core communication: parameter snapshots to DSP, status back to UI
+TripleBuffer<ParamMessage> gParamBuffer;
+Mailbox<StatusMessage> gStatusQueue;
+
+// CV and pot sampler, read by both tasks
+Adc gAdc;
 
 // Task instances
 static DspTask dspTask;
@@ -44,13 +50,10 @@ void setup() {
     Serial.println("Claudius - Harmonic Cascade Synthesizer");
     Serial.println("Starting...");
 
-    // Create communication queues
+    // Create the status queue
     // Using queue size 1 with overwrite for latest-value semantics
-    gParamQueue = xQueueCreate(1, sizeof(ParamMessage));
-    gStatusQueue = xQueueCreate(1, sizeof(StatusMessage));
-
-    if (!gParamQueue || !gStatusQueue) {
-        Serial.println("Failed to create queues!");
+    if (!gStatusQueue.create()) {
+        Serial.println("Failed to create status queue!");
         while (true) delay(1000);
     }
 
@@ -0,0 +1,412 @@
+// Claudius - DSP microbenchmark (host build)
+//
+// Renders each voice in isolation across a parameter sweep and prints one
+// CSV row per case, so results can be diffed between releases. Every case
+// is measured through the per-sample API and through processBlock() with
+// AUDIO_BLOCK_SIZE blocks.
+//
+// Usage: program [--samples N] [--repeats N] [--purity]
+//
+// Columns:
+//   voice, api, param, value, freq_hz, samples, ns_per_sample, cycles_per_sample,
+//   samples_per_sec, realtime_x
+// ns_per_sample and cycles_per_sample are medians over all repeats (cycles
+// from platform::cycleCount(), the TSC on x86); realtime_x is how many
+// times faster than SAMPLE_RATE the case renders on this machine.
+//
+// --purity prints the spectral purity of the shared sine oscillator
+// instead, next to a float-phase sinf() reference:
+//   osc, freq_hz, sfdr_db, sinad_db, max_error
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "Config.h"
+#include "dsp/ClaudiusEngine.h"
+#include "dsp/Envelope.h"
+#include "dsp/HarmonicCascade.h"
+#include "dsp/OrbitFm.h"
+#include "dsp/OscillatorCore.h"
+#include "dsp/PitchedVerb.h"
+#include "hal/CycleCounter.h"
+
+namespace {
+
+using BenchClock = std::chrono::steady_clock;
+
+// Keeps the optimizer from discarding rendered samples
+volatile float gSink = 0.0f;
+
+struct BenchOptions {
+    int samples = 88200;
+    int repeats = 5;
+    bool purity = false;
+};
+
+struct BenchResult {
+    double nsPerSample;
+    double cyclesPerSample;
+    double samplesPerSec;
+};
+
+// Run reset() then render(out, count) over `samples` samples in
+// AUDIO_BLOCK_SIZE blocks, `repeats` times over
+template<typename ResetFn, typename RenderFn>
+BenchResult measure(const BenchOptions& opts, ResetFn&& reset, RenderFn&& render) {
+    std::vector<double> runs;
+    std::vector<double> cycleRuns;
+    runs.reserve(opts.repeats);
+    cycleRuns.reserve(opts.repeats);
+    float block[AUDIO_BLOCK_SIZE];
+
+    for (int r = 0; r < opts.repeats; ++r) {
+        reset();
+        float acc = 0.0f;
+        auto start = BenchClock::now();
+        platform::CycleCount startCycles = platform::cycleCount();
+        for (int done = 0; done < opts.samples; done += AUDIO_BLOCK_SIZE) {
+            int count = std::min(AUDIO_BLOCK_SIZE, opts.samples - done);
+            render(block, count);
+            acc += block[count - 1];
+        }
+        platform::CycleCount cycles = platform::cycleCount() - startCycles;
+        auto end = BenchClock::now();
+        gSink = gSink + acc;
+
+        double ns = std::chrono::duration<double, std::nano>(end - start).count();
+        runs.push_back(ns / static_cast<double>(opts.samples));
+        cycleRuns.push_back(static_cast<double>(cycles) / static_cast<double>(opts.samples));
+    }
+
+    std::sort(runs.begin(), runs.end());
+    std::sort(cycleRuns.begin(), cycleRuns.end());
+    double median = runs[runs.size() / 2];
+    return {median, cycleRuns[cycleRuns.size() / 2], median > 0.0 ? 1.0e9 / median : 0.0};
+}
+
+void printHeader() {
+    std::printf("voice,api,param,value,freq_hz,samples,ns_per_sample,cycles_per_sample,"
+                "samples_per_sec,realtime_x\n");
+}
+
+void printRow(const char* voice, const char* api, const char* param, float value, float freq,
+              const BenchOptions& opts, const BenchResult& result) {
+    std::printf("%s,%s,%s,%.3f,%.2f,%d,%.3f,%.1f,%.0f,%.1f\n",
+        voice, api, param, value, freq, opts.samples,
+        result.nsPerSample, result.cyclesPerSample, result.samplesPerSec,
+        result.samplesPerSec / static_cast<double>(SAMPLE_RATE));
+}
+
+constexpr float kSweep[] = {0.0f, 0.25f, 0.5f, 0.75f, 1.0f};
+constexpr float kPitches[] = {MIN_FREQ, 110.0f, 220.0f, 440.0f, MAX_FREQ};
+constexpr float kDefaultFreq = 220.0f;
+
+// Unit-level envelope for voice cases, so only the voice is measured
+struct FlatEnvelope {
+    float level[AUDIO_BLOCK_SIZE];
+
+    FlatEnvelope() {
+        for (float& l : level) l = 1.0f;
+    }
+};
+
+const FlatEnvelope kFlat;
+
+void benchEnvelope(const BenchOptions& opts) {
+    Envelope env;
+    env.setAttack(0.0f);
+    env.setSustain(0.5f);  // Below full, so the gate-off fade is Release
+    auto reset = [&] { env.trigger(); env.process(); env.release(); };
+
+    for (int curve = 0; curve < static_cast<int>(EnvelopeCurve::NUM_CURVES); ++curve) {
+        constexpr const char* kCurveParams[] = {"release_exp", "release_log", "release_linear"};
+        env.setCurve(static_cast<EnvelopeCurve>(curve));
+        for (float release : kSweep) {
+            env.setRelease(release);
+            auto sample = measure(opts, reset, [&](float* out, int n) {
+                for (int i = 0; i < n; ++i) out[i] = env.process();
+            });
+            printRow("envelope", "sample", kCurveParams[curve], release, 0.0f, opts, sample);
+
+            auto block = measure(opts, reset, [&](float* out, int n) {
+                env.processBlock(out, n);
+            });
+            printRow("envelope", "block", kCurveParams[curve], release, 0.0f, opts, block);
+        }
+    }
+}
+
+void benchCascade(const BenchOptions& opts) {
+    HarmonicCascade osc;
+
+    auto run = [&](const char* param, float value, float freq,
+                   float spread, float cascade, float wavefold, float chaos) {
+        osc.setFrequency(freq);
+        osc.setSpread(spread);
+        osc.setCascade(cascade);
+        osc.setWavefold(wavefold);
+        osc.setChaos(chaos);
+        auto reset = [&] { osc.reset(); osc.trigger(); };
+
+        auto sample = measure(opts, reset, [&](float* out, int n) {
+            for (int i = 0; i < n; ++i) out[i] = osc.process(1.0f);
+        });
+        printRow("cascade", "sample", param, value, freq, opts, sample);
+
+        auto block = measure(opts, reset, [&](float* out, int n) {
+            osc.processBlock(out, kFlat.level, n);
+        });
+        printRow("cascade", "block", param, value, freq, opts, block);
+    };
+
+    for (float spread : kSweep) {
+        run("spread", spread, kDefaultFreq, spread, 0.5f, 0.0f, 0.0f);
+    }
+    for (float cascade : kSweep) {
+        run("cascade", cascade, kDefaultFreq, 1.0f, cascade, 0.0f, 0.0f);
+    }
+    for (float wavefold : kSweep) {
+        run("wavefold", wavefold, kDefaultFreq, 1.0f, 0.5f, wavefold, 0.0f);
+    }
+    for (float chaos : kSweep) {
+        run("chaos", chaos, kDefaultFreq, 1.0f, 0.5f, 0.0f, chaos);
+    }
+    for (float freq : kPitches) {
+        run("pitch", freq, freq, 1.0f, 0.5f, 0.0f, 0.0f);
+    }
+}
+
+void benchOrbitFm(const BenchOptions& opts) {
+    OrbitFm osc;
+
+    auto run = [&](const char* param, float value, float freq,
+                   float index, float ratio, float feedback, float fold) {
+        osc.setFrequency(freq);
+        osc.setIndex(index);
+        osc.setRatio(ratio);
+        osc.setFeedback(feedback);
+        osc.setFold(fold);
+        auto reset = [&] { osc.trigger(); };
+
+        auto sample = measure(opts, reset, [&](float* out, int n) {
+            for (int i = 0; i < n; ++i) out[i] = osc.process(1.0f);
+        });
+        printRow("orbit_fm", "sample", param, value, freq, opts, sample);
+
+        auto block = measure(opts, reset, [&](float* out, int n) {
+            osc.processBlock(out, kFlat.level, n);
+        });
+        printRow("orbit_fm", "block", param, value, freq, opts, block);
+    };
+
+    for (float index : kSweep) {
+        run("index", index, kDefaultFreq, index, 0.5f, 0.2f, 0.0f);
+    }
+    for (float fold : kSweep) {
+        run("fold", fold, kDefaultFreq, 0.5f, 0.5f, 0.2f, fold);
+    }
+    for (float freq : kPitches) {
+        run("pitch", freq, freq, 0.5f, 0.5f, 0.2f, 0.0f);
+    }
+}
+
+void benchPitchedVerb(const BenchOptions& opts) {
+    // ~80 KB of delay lines, borrowed from an arena off the stack
+    static VoiceArena arena;
+    static PitchedVerb verb;
+    verb.acquire(arena);
+    constexpr const char* kModeNames[] = {"pitched_verb", "pitched_verb_fdn"};
+
+    for (int mode = 0; mode < static_cast<int>(VerbMode::NUM_MODES); ++mode) {
+        const char* name = kModeNames[mode];
+        verb.setMode(static_cast<VerbMode>(mode));
+
+        auto run = [&](const char* param, float value, float freq,
+                       float feedback, float damp, float mix) {
+            verb.setFrequency(freq);
+            verb.setFeedback(feedback);
+            verb.setDamp(damp);
+            verb.setMix(mix);
+            auto reset = [&] { verb.reset(); verb.trigger(); };
+
+            auto sample = measure(opts, reset, [&](float* out, int n) {
+                for (int i = 0; i < n; ++i) out[i] = verb.process(1.0f);
+            });
+            printRow(name, "sample", param, value, freq, opts, sample);
+
+            auto block = measure(opts, reset, [&](float* out, int n) {
+                verb.processBlock(out, kFlat.level, n);
+            });
+            printRow(name, "block", param, value, freq, opts, block);
+        };
+
+        for (float feedback : kSweep) {
+            run("feedback", feedback, kDefaultFreq, feedback, 0.3f, 0.6f);
+        }
+        for (float mix : kSweep) {
+            run("mix", mix, kDefaultFreq, 0.4f, 0.3f, mix);
+        }
+        for (float freq : kPitches) {
+            run("pitch", freq, freq, 0.4f, 0.3f, 0.6f);
+        }
+    }
+}
+
+// Whole engine (envelope + voice + output guard), held gate
+void benchEngine(const BenchOptions& opts) {
+    static ClaudiusEngine engine;
+    for (int v = 0; v < ClaudiusVoices::kCount; ++v) {
+        const VoiceInfo& info = ClaudiusVoices::info(v);
+        ParamMessage params = makeDefaultParams();
+        params.voice = static_cast<uint8_t>(info.type);
+        params.pot0 = 1.0f;
+        params.gateIn = true;
+        auto reset = [&] { engine.gate(false); engine.applyParams(params); };
+
+        auto sample = measure(opts, reset, [&](float* out, int n) {
+            for (int i = 0; i < n; ++i) out[i] = engine.process();
+        });
+        printRow("engine", "sample", info.slug, 1.0f, engine.getFrequency(), opts, sample);
+
+        auto block = measure(opts, reset, [&](float* out, int n) {
+            engine.processBlock(out, n);
+        });
+        printRow("engine", "block", info.slug, 1.0f, engine.getFrequency(), opts, block);
+    }
+}
+
+// Spectral purity: render a bin-centred tone (no window needed) and compare
+// the fundamental against the largest spur and against everything else.
+constexpr int kFftSize = 16384;
+
+void fft(std::vector<std::complex<double>>& data) {
+    const int n = static_cast<int>(data.size());
+    for (int i = 1, j = 0; i < n; ++i) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(data[i], data[j]);
+    }
+    for (int len = 2; len <= n; len <<= 1) {
+        double angle = -2.0 * sine_table_detail::kPi / static_cast<double>(len);
+        std::complex<double> step(std::cos(angle), std::sin(angle));
+        for (int i = 0; i < n; i += len) {
+            std::complex<double> w(1.0, 0.0);
+            for (int k = 0; k < len / 2; ++k) {
+                std::complex<double> a = data[i + k];
+                std::complex<double> b = data[i + k + len / 2] * w;
+                data[i + k] = a + b;
+                data[i + k + len / 2] = a - b;
+                w *= step;
+            }
+        }
+    }
+}
+
+struct PurityResult {
+    double sfdrDb;
+    double sinadDb;
+    double maxError;
+};
+
+template<typename NextFn>
+PurityResult analysePurity(int bin, NextFn&& next) {
+    std::vector<std::complex<double>> spectrum(kFftSize);
+    double maxError = 0.0;
+    for (int i = 0; i < kFftSize; ++i) {
+        double value = next();
+        double exact = std::sin(2.0 * sine_table_detail::kPi * static_cast<double>(bin)
+                                * static_cast<double>(i + 1) / static_cast<double>(kFftSize));
+        maxError = std::max(maxError, std::fabs(value - exact));
+        spectrum[i] = value;
+    }
+    fft(spectrum);
+
+    double fundamental = std::norm(spectrum[bin]);
+    double worstSpur = 1e-300;
+    double rest = 1e-300;
+    for (int k = 0; k <= kFftSize / 2; ++k) {
+        if (k == bin) continue;
+        double power = std::norm(spectrum[k]);
+        worstSpur = std::max(worstSpur, power);
+        rest += power;
+    }
+    return {10.0 * std::log10(fundamental / worstSpur),
+            10.0 * std::log10(fundamental / rest),
+            maxError};
+}
+
+void benchPurity() {
+    std::printf("osc,freq_hz,sfdr_db,sinad_db,max_error\n");
+    constexpr float kPurityPitches[] = {MIN_FREQ, 220.0f, MAX_FREQ, 5000.0f, 15000.0f};
+
+    for (float pitch : kPurityPitches) {
+        int bin = std::max(1, static_cast<int>(std::lround(pitch * kFftSize / SAMPLE_RATE)));
+        double freq = static_cast<double>(bin) * SAMPLE_RATE / kFftSize;
+
+        // Exact bin increment (kFftSize is a power of two) so both
+        // oscillators land on the bin and only waveform error remains
+        Phase phase = 0;
+        const Phase increment = static_cast<Phase>(bin) << (32 - 14);
+        static_assert(kFftSize == 1 << 14, "increment shift assumes 2^14 points");
+        PurityResult table = analysePurity(bin, [&] {
+            phase += increment;
+            return static_cast<double>(sineLookup(phase));
+        });
+        std::printf("table,%.2f,%.1f,%.1f,%.3g\n", freq, table.sfdrDb, table.sinadDb, table.maxError);
+
+        float floatPhase = 0.0f;
+        const float floatIncrement = static_cast<float>(bin) / static_cast<float>(kFftSize);
+        PurityResult reference = analysePurity(bin, [&] {
+            floatPhase += floatIncrement;
+            if (floatPhase >= 1.0f) floatPhase -= 1.0f;
+            return static_cast<double>(sinf(floatPhase * 2.0f * static_cast<float>(M_PI)));
+        });
+        std::printf("sinf,%.2f,%.1f,%.1f,%.3g\n", freq, reference.sfdrDb, reference.sinadDb,
+                    reference.maxError);
+    }
+}
+
+bool parseArgs(int argc, char** argv, BenchOptions& opts) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+            opts.samples = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--repeats") == 0 && i + 1 < argc) {
+            opts.repeats = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--purity") == 0) {
+            opts.purity = true;
+        } else {
+            std::fprintf(stderr, "usage: %s [--samples N] [--repeats N] [--purity]\n", argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions opts;
+    if (!parseArgs(argc, argv, opts)) {
+        return 1;
+    }
+
+    if (opts.purity) {
+        benchPurity();
+        return 0;
+    }
+
+    printHeader();
+    benchEnvelope(opts);
+    benchCascade(opts);
+    benchOrbitFm(opts);
+    benchPitchedVerb(opts);
+    benchEngine(opts);
+    return 0;
+}
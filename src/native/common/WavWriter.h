@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include "Utils.h"
+
+// Streaming mono WAV writer for host tools.
+// Writes the header up front and patches the chunk sizes on close(),
+// so renders of any length never need to be held in memory.
+
+class WavWriter {
+public:
+    enum class Format : uint8_t {
+        FLOAT32,
+        PCM16
+    };
+
+    WavWriter() = default;
+    WavWriter(const WavWriter&) = delete;
+    WavWriter& operator=(const WavWriter&) = delete;
+
+    ~WavWriter() {
+        close();
+    }
+
+    bool open(const char* path, uint32_t sampleRate, Format format = Format::FLOAT32) {
+        close();
+        file_ = std::fopen(path, "wb");
+        if (!file_) {
+            return false;
+        }
+        sampleRate_ = sampleRate;
+        format_ = format;
+        frames_ = 0;
+        writeHeader();
+        return true;
+    }
+
+    bool isOpen() const {
+        return file_ != nullptr;
+    }
+
+    void write(const float* samples, int count) {
+        if (!file_) return;
+
+        if (format_ == Format::FLOAT32) {
+            std::fwrite(samples, sizeof(float), static_cast<size_t>(count), file_);
+        } else {
+            int16_t pcm[256];
+            int done = 0;
+            while (done < count) {
+                int chunk = count - done < 256 ? count - done : 256;
+                for (int i = 0; i < chunk; ++i) {
+                    float s = clamp(samples[done + i], -1.0f, 1.0f);
+                    pcm[i] = static_cast<int16_t>(s * 32767.0f);
+                }
+                std::fwrite(pcm, sizeof(int16_t), static_cast<size_t>(chunk), file_);
+                done += chunk;
+            }
+        }
+        frames_ += static_cast<uint32_t>(count);
+    }
+
+    void close() {
+        if (!file_) return;
+        std::fseek(file_, 0, SEEK_SET);
+        writeHeader();
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+
+    uint32_t frames() const {
+        return frames_;
+    }
+
+private:
+    void writeHeader() {
+        const uint16_t bytesPerSample = (format_ == Format::FLOAT32) ? 4 : 2;
+        const uint16_t formatTag = (format_ == Format::FLOAT32) ? 3 : 1;
+        const uint32_t dataBytes = frames_ * bytesPerSample;
+
+        writeTag("RIFF");
+        writeU32(36 + dataBytes);
+        writeTag("WAVE");
+        writeTag("fmt ");
+        writeU32(16);
+        writeU16(formatTag);
+        writeU16(1);  // mono
+        writeU32(sampleRate_);
+        writeU32(sampleRate_ * bytesPerSample);
+        writeU16(bytesPerSample);
+        writeU16(static_cast<uint16_t>(bytesPerSample * 8));
+        writeTag("data");
+        writeU32(dataBytes);
+    }
+
+    void writeTag(const char* tag) {
+        std::fwrite(tag, 1, 4, file_);
+    }
+
+    void writeU16(uint16_t value) {
+        uint8_t bytes[2] = {
+            static_cast<uint8_t>(value & 0xFF),
+            static_cast<uint8_t>(value >> 8)
+        };
+        std::fwrite(bytes, 1, 2, file_);
+    }
+
+    void writeU32(uint32_t value) {
+        uint8_t bytes[4] = {
+            static_cast<uint8_t>(value & 0xFF),
+            static_cast<uint8_t>((value >> 8) & 0xFF),
+            static_cast<uint8_t>((value >> 16) & 0xFF),
+            static_cast<uint8_t>(value >> 24)
+        };
+        std::fwrite(bytes, 1, 4, file_);
+    }
+
+    std::FILE* file_ = nullptr;
+    uint32_t sampleRate_ = 0;
+    uint32_t frames_ = 0;
+    Format format_ = Format::FLOAT32;
+};
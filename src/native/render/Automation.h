@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "Config.h"
+#include "Parameters.h"
+#include "ParamTable.h"
+#include "dsp/Voices.h"
+
+// Parameter automation for offline renders.
+//
+// Text format, one event per line ('#' starts a comment):
+//   <seconds> <field> <value>
+//   0.000 voice orbit
+//   0.000 pot2 0.35
+//   0.010 gate 1
+//
+// Binary format (little endian):
+//   "CLAUDAUT" | u32 version | u32 sampleRate | u32 count
+//   count x { u32 frame | u16 field | u16 reserved | f32 value }
+//
+// Fields are the parameter table keys (ParamTable.h) and the binary field
+// IDs are ParamIds; gate drives gateIn. envCurve takes 0 = exp, 1 = log,
+// 2 = linear; verbMode takes 0 = comb, 1 = fdn.
+
+// Voice ID for a registered voice's slug, or -1
+inline int findVoiceSlug(const char* text) {
+    for (int i = 0; i < ClaudiusVoices::kCount; ++i) {
+        if (std::strcmp(text, ClaudiusVoices::info(i).slug) == 0) {
+            return static_cast<int>(ClaudiusVoices::info(i).type);
+        }
+    }
+    return -1;
+}
+
+struct AutomationEvent {
+    uint32_t frame;
+    ParamId field;
+    float value;
+};
+
+inline void applyAutomationEvent(const AutomationEvent& event, ParamMessage& params) {
+    setParam(params, event.field, event.value);
+}
+
+class Automation {
+public:
+    static constexpr char kMagic[8] = {'C', 'L', 'A', 'U', 'D', 'A', 'U', 'T'};
+    static constexpr uint32_t kVersion = 1;
+
+    // Loads either format, detected by the magic. Events are sorted by frame.
+    bool load(const char* path, uint32_t sampleRate) {
+        events_.clear();
+        std::FILE* file = std::fopen(path, "rb");
+        if (!file) {
+            std::fprintf(stderr, "automation: cannot open %s\n", path);
+            return false;
+        }
+
+        char magic[sizeof(kMagic)] = {};
+        size_t got = std::fread(magic, 1, sizeof(magic), file);
+        std::rewind(file);
+
+        bool ok = (got == sizeof(magic) && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0)
+            ? loadBinary(file, sampleRate)
+            : loadText(file, sampleRate);
+        std::fclose(file);
+
+        std::stable_sort(events_.begin(), events_.end(),
+            [](const AutomationEvent& a, const AutomationEvent& b) { return a.frame < b.frame; });
+        return ok;
+    }
+
+    bool saveBinary(const char* path, uint32_t sampleRate) const {
+        std::FILE* file = std::fopen(path, "wb");
+        if (!file) return false;
+
+        std::fwrite(kMagic, 1, sizeof(kMagic), file);
+        writeU32(file, kVersion);
+        writeU32(file, sampleRate);
+        writeU32(file, static_cast<uint32_t>(events_.size()));
+        for (const AutomationEvent& event : events_) {
+            writeU32(file, event.frame);
+            writeU32(file, static_cast<uint32_t>(event.field));
+            uint32_t bits;
+            std::memcpy(&bits, &event.value, sizeof(bits));
+            writeU32(file, bits);
+        }
+        return std::fclose(file) == 0;
+    }
+
+    const std::vector<AutomationEvent>& events() const {
+        return events_;
+    }
+
+    uint32_t lastFrame() const {
+        return events_.empty() ? 0 : events_.back().frame;
+    }
+
+private:
+    bool loadText(std::FILE* file, uint32_t sampleRate) {
+        char line[256];
+        int lineNo = 0;
+        while (std::fgets(line, sizeof(line), file)) {
+            ++lineNo;
+            char* hash = std::strchr(line, '#');
+            if (hash) *hash = '\0';
+
+            char fieldName[64];
+            char valueText[64];
+            double seconds = 0.0;
+            int n = std::sscanf(line, "%lf %63s %63s", &seconds, fieldName, valueText);
+            if (n <= 0) continue;
+            if (n != 3 || seconds < 0.0) {
+                std::fprintf(stderr, "automation:%d: expected '<seconds> <field> <value>'\n", lineNo);
+                return false;
+            }
+
+            int field = findParamKey(fieldName);
+            if (field < 0) {
+                std::fprintf(stderr, "automation:%d: unknown field '%s'\n", lineNo, fieldName);
+                return false;
+            }
+
+            float value = 0.0f;
+            int voice = findVoiceSlug(valueText);
+            if (static_cast<ParamId>(field) == ParamId::VOICE && voice >= 0) {
+                value = static_cast<float>(voice);
+            } else {
+                char* end = nullptr;
+                value = std::strtof(valueText, &end);
+                if (end == valueText) {
+                    std::fprintf(stderr, "automation:%d: bad value '%s'\n", lineNo, valueText);
+                    return false;
+                }
+            }
+
+            AutomationEvent event;
+            event.frame = static_cast<uint32_t>(seconds * sampleRate + 0.5);
+            event.field = static_cast<ParamId>(field);
+            event.value = value;
+            events_.push_back(event);
+        }
+        return true;
+    }
+
+    bool loadBinary(std::FILE* file, uint32_t sampleRate) {
+        char magic[sizeof(kMagic)];
+        uint32_t version = 0;
+        uint32_t fileRate = 0;
+        uint32_t count = 0;
+        if (std::fread(magic, 1, sizeof(magic), file) != sizeof(magic)
+            || !readU32(file, version) || !readU32(file, fileRate) || !readU32(file, count)) {
+            std::fprintf(stderr, "automation: truncated header\n");
+            return false;
+        }
+        if (version != kVersion) {
+            std::fprintf(stderr, "automation: unsupported version %u\n", version);
+            return false;
+        }
+
+        events_.reserve(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t frame = 0;
+            uint32_t field = 0;
+            uint32_t bits = 0;
+            if (!readU32(file, frame) || !readU32(file, field) || !readU32(file, bits)) {
+                std::fprintf(stderr, "automation: truncated at event %u\n", i);
+                return false;
+            }
+            field &= 0xFFFF;
+            if (field >= static_cast<uint32_t>(ParamId::NUM_PARAMS)) {
+                std::fprintf(stderr, "automation: bad field id %u\n", field);
+                return false;
+            }
+
+            AutomationEvent event;
+            // Rescale if the file was written for another sample rate
+            event.frame = (fileRate == sampleRate || fileRate == 0)
+                ? frame
+                : static_cast<uint32_t>(static_cast<double>(frame) * sampleRate / fileRate);
+            event.field = static_cast<ParamId>(field);
+            std::memcpy(&event.value, &bits, sizeof(bits));
+            events_.push_back(event);
+        }
+        return true;
+    }
+
+    static void writeU32(std::FILE* file, uint32_t value) {
+        uint8_t bytes[4] = {
+            static_cast<uint8_t>(value & 0xFF),
+            static_cast<uint8_t>((value >> 8) & 0xFF),
+            static_cast<uint8_t>((value >> 16) & 0xFF),
+            static_cast<uint8_t>(value >> 24)
+        };
+        std::fwrite(bytes, 1, 4, file);
+    }
+
+    static bool readU32(std::FILE* file, uint32_t& value) {
+        uint8_t bytes[4];
+        if (std::fread(bytes, 1, 4, file) != 4) return false;
+        value = static_cast<uint32_t>(bytes[0])
+            | (static_cast<uint32_t>(bytes[1]) << 8)
+            | (static_cast<uint32_t>(bytes[2]) << 16)
+            | (static_cast<uint32_t>(bytes[3]) << 24);
+        return true;
+    }
+
+    std::vector<AutomationEvent> events_;
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Streaming fingerprint of a render.
+// hash: FNV-1a 64 over the raw float bits, for bit-exact checks.
+// rms:  RMS of kSegments equal slices, for tolerance checks when the
+//       hash no longer matches (e.g. after a float reassociation).
+
+class RenderFingerprint {
+public:
+    static constexpr int kSegments = 32;
+
+    void begin(uint32_t totalFrames) {
+        hash_ = 0xcbf29ce484222325ull;
+        frames_ = 0;
+        totalFrames_ = totalFrames > 0 ? totalFrames : 1;
+        for (int i = 0; i < kSegments; ++i) {
+            sumSquares_[i] = 0.0;
+            counts_[i] = 0;
+        }
+    }
+
+    void add(const float* samples, int count) {
+        for (int i = 0; i < count; ++i) {
+            uint32_t bits;
+            std::memcpy(&bits, &samples[i], sizeof(bits));
+            for (int b = 0; b < 4; ++b) {
+                hash_ ^= (bits >> (b * 8)) & 0xFF;
+                hash_ *= 0x100000001b3ull;
+            }
+
+            int segment = static_cast<int>(
+                static_cast<uint64_t>(frames_) * kSegments / totalFrames_);
+            if (segment >= kSegments) segment = kSegments - 1;
+            sumSquares_[segment] += static_cast<double>(samples[i]) * samples[i];
+            counts_[segment]++;
+            frames_++;
+        }
+    }
+
+    uint64_t hash() const {
+        return hash_;
+    }
+
+    uint32_t frames() const {
+        return frames_;
+    }
+
+    float segmentRms(int segment) const {
+        if (counts_[segment] == 0) return 0.0f;
+        return static_cast<float>(std::sqrt(sumSquares_[segment] / counts_[segment]));
+    }
+
+private:
+    uint64_t hash_ = 0;
+    uint32_t frames_ = 0;
+    uint32_t totalFrames_ = 1;
+    double sumSquares_[kSegments] = {};
+    uint32_t counts_[kSegments] = {};
+};
+
+// One line per voice in a golden file:
+//   <voice> <frames> <hash hex> <rms 0> ... <rms 31>
+struct GoldenEntry {
+    std::string voice;
+    uint32_t frames = 0;
+    uint64_t hash = 0;
+    float rms[RenderFingerprint::kSegments] = {};
+};
+
+inline void writeGoldenEntry(std::FILE* file, const char* voice, const RenderFingerprint& fp) {
+    std::fprintf(file, "%s %u %016llx", voice, fp.frames(),
+        static_cast<unsigned long long>(fp.hash()));
+    for (int i = 0; i < RenderFingerprint::kSegments; ++i) {
+        std::fprintf(file, " %.6f", fp.segmentRms(i));
+    }
+    std::fprintf(file, "\n");
+}
+
+inline bool readGoldenFile(const char* path, std::vector<GoldenEntry>& entries) {
+    std::FILE* file = std::fopen(path, "r");
+    if (!file) return false;
+
+    char line[1024];
+    while (std::fgets(line, sizeof(line), file)) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+
+        GoldenEntry entry;
+        char voice[32];
+        unsigned long long hash = 0;
+        int offset = 0;
+        if (std::sscanf(line, "%31s %u %llx%n", voice, &entry.frames, &hash, &offset) < 3) {
+            continue;
+        }
+        entry.voice = voice;
+        entry.hash = hash;
+
+        const char* cursor = line + offset;
+        for (int i = 0; i < RenderFingerprint::kSegments; ++i) {
+            int used = 0;
+            if (std::sscanf(cursor, "%f%n", &entry.rms[i], &used) != 1) break;
+            cursor += used;
+        }
+        entries.push_back(entry);
+    }
+    std::fclose(file);
+    return true;
+}
+
+// Largest per-segment RMS difference between a render and its golden entry
+inline float maxRmsDifference(const RenderFingerprint& fp, const GoldenEntry& golden) {
+    float worst = 0.0f;
+    for (int i = 0; i < RenderFingerprint::kSegments; ++i) {
+        float diff = std::fabs(fp.segmentRms(i) - golden.rms[i]);
+        if (diff > worst) worst = diff;
+    }
+    return worst;
+}
@@ -0,0 +1,262 @@
+// Claudius - offline renderer (host build)
+//
+// Renders ClaudiusEngine from a parameter automation file, faster than
+// realtime, streaming blocks straight to a WAV file. Parameters are applied
+// at block boundaries, the same way DspTask picks them up from the queue.
+//
+// Usage:
+//   program [options] <automation>
+//     -o FILE             write a WAV file (float32 unless --pcm16)
+//     --pcm16             write 16-bit PCM instead of float32
+//     --seconds S         render length (default: last event + 2 s)
+//     --voice NAME        force cascade|orbit|verb for the whole render
+//     --hash              print a per-voice fingerprint of the render
+//     --golden FILE       compare per-voice fingerprints against FILE
+//     --write-golden FILE store per-voice fingerprints in FILE
+//     --tolerance T       accept hash mismatches whose segment RMS differ by <= T
+//     --write-binary FILE convert the automation to the binary format
+//
+// In --hash/--golden/--write-golden mode every voice is rendered with the
+// automation in turn (voice events are overridden). Exit status is 1 if any
+// voice fails its golden comparison.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "Config.h"
+#include "Parameters.h"
+#include "dsp/ClaudiusEngine.h"
+#include "native/common/WavWriter.h"
+#include "native/render/Automation.h"
+#include "native/render/GoldenHash.h"
+
+namespace {
+
+using RenderClock = std::chrono::steady_clock;
+
+constexpr uint32_t kRenderRate = static_cast<uint32_t>(SAMPLE_RATE);
+constexpr float kDefaultTailSeconds = 2.0f;
+
+struct RenderOptions {
+    const char* automationPath = nullptr;
+    const char* outPath = nullptr;
+    const char* goldenPath = nullptr;
+    const char* writeGoldenPath = nullptr;
+    const char* binaryPath = nullptr;
+    float seconds = -1.0f;
+    float tolerance = -1.0f;
+    int voice = -1;
+    bool pcm16 = false;
+    bool hash = false;
+};
+
+// Render `totalFrames` frames, handing each block to sink(samples, count)
+template<typename Sink>
+double renderAutomation(const Automation& automation, int forcedVoice,
+                        uint32_t totalFrames, Sink&& sink) {
+    auto engine = std::make_unique<ClaudiusEngine>(SAMPLE_RATE);
+    ParamMessage params = makeDefaultParams();
+    const std::vector<AutomationEvent>& events = automation.events();
+    size_t nextEvent = 0;
+    float block[AUDIO_BLOCK_SIZE];
+
+    auto start = RenderClock::now();
+    for (uint32_t frame = 0; frame < totalFrames; frame += AUDIO_BLOCK_SIZE) {
+        while (nextEvent < events.size() && events[nextEvent].frame <= frame) {
+            applyAutomationEvent(events[nextEvent], params);
+            ++nextEvent;
+        }
+        if (forcedVoice >= 0) {
+            setParam(params, ParamId::VOICE, static_cast<float>(forcedVoice));
+        }
+        // Like the DSP task, only the stages whose parameters changed
+        engine->applyParams(params, params.dirty);
+        params.dirty = 0;
+
+        uint32_t remaining = totalFrames - frame;
+        int count = remaining < AUDIO_BLOCK_SIZE ? static_cast<int>(remaining) : AUDIO_BLOCK_SIZE;
+        engine->processBlock(block, count);
+        sink(block, count);
+    }
+    auto end = RenderClock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+void printSpeed(const char* label, uint32_t frames, double seconds) {
+    double audioSeconds = static_cast<double>(frames) / kRenderRate;
+    std::fprintf(stderr, "%s: %.2f s audio in %.3f s (%.1fx realtime)\n",
+        label, audioSeconds, seconds, seconds > 0.0 ? audioSeconds / seconds : 0.0);
+}
+
+int runWav(const RenderOptions& opts, const Automation& automation, uint32_t totalFrames) {
+    WavWriter wav;
+    WavWriter::Format format = opts.pcm16 ? WavWriter::Format::PCM16 : WavWriter::Format::FLOAT32;
+    if (!wav.open(opts.outPath, kRenderRate, format)) {
+        std::fprintf(stderr, "cannot open %s for writing\n", opts.outPath);
+        return 1;
+    }
+
+    double elapsed = renderAutomation(automation, opts.voice, totalFrames,
+        [&](const float* samples, int count) { wav.write(samples, count); });
+    wav.close();
+    printSpeed(opts.outPath, totalFrames, elapsed);
+    return 0;
+}
+
+int runFingerprints(const RenderOptions& opts, const Automation& automation, uint32_t totalFrames) {
+    std::vector<GoldenEntry> golden;
+    if (opts.goldenPath && !readGoldenFile(opts.goldenPath, golden)) {
+        std::fprintf(stderr, "cannot read golden file %s\n", opts.goldenPath);
+        return 1;
+    }
+
+    std::FILE* goldenOut = nullptr;
+    if (opts.writeGoldenPath) {
+        goldenOut = std::fopen(opts.writeGoldenPath, "w");
+        if (!goldenOut) {
+            std::fprintf(stderr, "cannot open %s for writing\n", opts.writeGoldenPath);
+            return 1;
+        }
+        std::fprintf(goldenOut, "# Claudius golden renders: %s\n", opts.automationPath);
+        std::fprintf(goldenOut, "# voice frames fnv1a64 rms[%d]\n", RenderFingerprint::kSegments);
+    }
+
+    if (opts.goldenPath) {
+        std::printf("voice,status,hash,golden_hash,max_rms_diff\n");
+    }
+
+    int failures = 0;
+    for (int i = 0; i < ClaudiusVoices::kCount; ++i) {
+        const int v = static_cast<int>(ClaudiusVoices::info(i).type);
+        const char* slug = ClaudiusVoices::info(i).slug;
+        if (opts.voice >= 0 && opts.voice != v) continue;
+
+        RenderFingerprint fp;
+        fp.begin(totalFrames);
+        double elapsed = renderAutomation(automation, v, totalFrames,
+            [&](const float* samples, int count) { fp.add(samples, count); });
+        printSpeed(slug, totalFrames, elapsed);
+
+        if (goldenOut) {
+            writeGoldenEntry(goldenOut, slug, fp);
+        }
+        if (opts.hash && !opts.goldenPath) {
+            std::printf("%s %016llx\n", slug, static_cast<unsigned long long>(fp.hash()));
+        }
+        if (!opts.goldenPath) continue;
+
+        const GoldenEntry* entry = nullptr;
+        for (const GoldenEntry& candidate : golden) {
+            if (candidate.voice == slug) entry = &candidate;
+        }
+
+        const char* status = "missing";
+        float diff = 0.0f;
+        if (entry) {
+            diff = maxRmsDifference(fp, *entry);
+            if (entry->frames != fp.frames()) {
+                status = "length";
+            } else if (entry->hash == fp.hash()) {
+                status = "exact";
+            } else if (opts.tolerance >= 0.0f && diff <= opts.tolerance) {
+                status = "within_tolerance";
+            } else {
+                status = "mismatch";
+            }
+        }
+        bool pass = std::strcmp(status, "exact") == 0 || std::strcmp(status, "within_tolerance") == 0;
+        if (!pass) ++failures;
+
+        std::printf("%s,%s,%016llx,%016llx,%.6f\n", slug, status,
+            static_cast<unsigned long long>(fp.hash()),
+            static_cast<unsigned long long>(entry ? entry->hash : 0), diff);
+    }
+
+    if (goldenOut) {
+        std::fclose(goldenOut);
+    }
+    return failures > 0 ? 1 : 0;
+}
+
+void printUsage(const char* program) {
+    std::fprintf(stderr,
+        "usage: %s [-o out.wav] [--pcm16] [--seconds S] [--voice cascade|orbit|verb]\n"
+        "          [--hash] [--golden FILE] [--write-golden FILE] [--tolerance T]\n"
+        "          [--write-binary FILE] <automation>\n", program);
+}
+
+bool parseArgs(int argc, char** argv, RenderOptions& opts) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "-o") == 0 && hasValue) {
+            opts.outPath = argv[++i];
+        } else if (std::strcmp(arg, "--pcm16") == 0) {
+            opts.pcm16 = true;
+        } else if (std::strcmp(arg, "--seconds") == 0 && hasValue) {
+            opts.seconds = std::strtof(argv[++i], nullptr);
+        } else if (std::strcmp(arg, "--voice") == 0 && hasValue) {
+            opts.voice = findVoiceSlug(argv[++i]);
+            if (opts.voice < 0) {
+                std::fprintf(stderr, "unknown voice '%s'\n", argv[i]);
+                return false;
+            }
+        } else if (std::strcmp(arg, "--hash") == 0) {
+            opts.hash = true;
+        } else if (std::strcmp(arg, "--golden") == 0 && hasValue) {
+            opts.goldenPath = argv[++i];
+        } else if (std::strcmp(arg, "--write-golden") == 0 && hasValue) {
+            opts.writeGoldenPath = argv[++i];
+        } else if (std::strcmp(arg, "--tolerance") == 0 && hasValue) {
+            opts.tolerance = std::strtof(argv[++i], nullptr);
+        } else if (std::strcmp(arg, "--write-binary") == 0 && hasValue) {
+            opts.binaryPath = argv[++i];
+        } else if (arg[0] != '-' && !opts.automationPath) {
+            opts.automationPath = arg;
+        } else {
+            return false;
+        }
+    }
+    return opts.automationPath != nullptr;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    RenderOptions opts;
+    if (!parseArgs(argc, argv, opts)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    Automation automation;
+    if (!automation.load(opts.automationPath, kRenderRate)) {
+        return 2;
+    }
+
+    if (opts.binaryPath && !automation.saveBinary(opts.binaryPath, kRenderRate)) {
+        std::fprintf(stderr, "cannot write %s\n", opts.binaryPath);
+        return 2;
+    }
+
+    uint32_t totalFrames = (opts.seconds > 0.0f)
+        ? static_cast<uint32_t>(opts.seconds * kRenderRate)
+        : automation.lastFrame() + static_cast<uint32_t>(kDefaultTailSeconds * kRenderRate);
+
+    bool fingerprintMode = opts.hash || opts.goldenPath || opts.writeGoldenPath;
+    if (fingerprintMode) {
+        return runFingerprints(opts, automation, totalFrames);
+    }
+    if (opts.outPath) {
+        return runWav(opts, automation, totalFrames);
+    }
+    if (!opts.binaryPath) {
+        printUsage(argv[0]);
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "Calibration.h"
+#include "hal/host/SimClock.h"
+#include "hal/host/SimInputs.h"
+
+// Front-panel script for the simulator, one event per line:
+//   <seconds> <input> <value>
+// inputs: cv0 cv1 cv2 pot0 pot1 pot2   normalized 0-1, as read after calibration
+//         gate                         0 or 1
+//         enc                          signed detents, e.g. +2 or -1
+//         press                        number of button presses
+//         hold                         0 or 1
+
+enum class SimInput : uint8_t {
+    CV0 = 0,
+    CV1,
+    CV2,
+    POT0,
+    POT1,
+    POT2,
+    GATE,
+    ENC,
+    PRESS,
+    HOLD,
+    NUM_INPUTS
+};
+
+constexpr const char* kSimInputNames[] = {
+    "cv0", "cv1", "cv2", "pot0", "pot1", "pot2", "gate", "enc", "press", "hold"
+};
+
+static_assert(sizeof(kSimInputNames) / sizeof(kSimInputNames[0])
+              == static_cast<size_t>(SimInput::NUM_INPUTS),
+              "input name table out of sync");
+
+struct SimEvent {
+    uint32_t ms;
+    SimInput input;
+    float value;
+};
+
+inline bool isAnalogInput(SimInput input) {
+    return static_cast<uint8_t>(input) < SimInputs::NUM_CHANNELS;
+}
+
+inline const AdcCalibration& calibrationFor(SimInput input) {
+    static const AdcCalibration* const kCal[SimInputs::NUM_CHANNELS] = {
+        &CAL_CV0, &CAL_CV1, &CAL_CV2, &CAL_POT0, &CAL_POT1, &CAL_POT2
+    };
+    return *kCal[static_cast<uint8_t>(input)];
+}
+
+// Inverse of normalizeAdc(): the raw reading that normalizes to `normalized`
+inline uint16_t rawForNormalized(float normalized, const AdcCalibration& cal) {
+    float v = clamp(normalized, 0.0f, 1.0f);
+    if (cal.invert) v = 1.0f - v;
+    float raw = cal.minValue + v * static_cast<float>(cal.maxValue - cal.minValue);
+    return static_cast<uint16_t>(raw + 0.5f);
+}
+
+inline void applySimEvent(const SimEvent& event, SimInputs& inputs) {
+    if (isAnalogInput(event.input)) {
+        inputs.raw[static_cast<uint8_t>(event.input)] =
+            rawForNormalized(event.value, calibrationFor(event.input));
+        return;
+    }
+    switch (event.input) {
+        case SimInput::GATE: {
+            // Queue the edge with its time, as the gate interrupt does
+            bool high = event.value >= 0.5f;
+            if (inputs.gateIn.exchange(high) != high
+                && !inputs.gateEdges.push(GateEdge{simClock().micros(), high})) {
+                inputs.droppedGateEdges++;
+            }
+            break;
+        }
+        case SimInput::ENC: inputs.encoderSteps += static_cast<int>(event.value); break;
+        case SimInput::PRESS: inputs.buttonPresses += std::max(1, static_cast<int>(event.value)); break;
+        case SimInput::HOLD: inputs.buttonHeld = event.value >= 0.5f; break;
+        default: break;
+    }
+    // Turns and presses wake the UI, as the encoder interrupts do
+    if (event.input == SimInput::ENC || event.input == SimInput::PRESS) {
+        if (SimWake* task = inputs.encoderTask.load()) {
+            simClock().notify(*task);
+        }
+    }
+}
+
+inline bool loadSimScript(const char* path, std::vector<SimEvent>& events) {
+    std::FILE* file = std::fopen(path, "r");
+    if (!file) {
+        std::fprintf(stderr, "script: cannot open %s\n", path);
+        return false;
+    }
+
+    char line[256];
+    int lineNo = 0;
+    bool ok = true;
+    while (ok && std::fgets(line, sizeof(line), file)) {
+        ++lineNo;
+        char* hash = std::strchr(line, '#');
+        if (hash) *hash = '\0';
+
+        double seconds = 0.0;
+        char name[32];
+        float value = 0.0f;
+        int n = std::sscanf(line, "%lf %31s %f", &seconds, name, &value);
+        if (n <= 0) continue;
+        if (n != 3 || seconds < 0.0) {
+            std::fprintf(stderr, "script:%d: expected '<seconds> <input> <value>'\n", lineNo);
+            ok = false;
+            break;
+        }
+
+        int input = -1;
+        for (int i = 0; i < static_cast<int>(SimInput::NUM_INPUTS); ++i) {
+            if (std::strcmp(name, kSimInputNames[i]) == 0) input = i;
+        }
+        if (input < 0) {
+            std::fprintf(stderr, "script:%d: unknown input '%s'\n", lineNo, name);
+            ok = false;
+            break;
+        }
+
+        events.push_back({static_cast<uint32_t>(seconds * 1000.0 + 0.5),
+                          static_cast<SimInput>(input), value});
+    }
+    std::fclose(file);
+
+    std::stable_sort(events.begin(), events.end(),
+        [](const SimEvent& a, const SimEvent& b) { return a.ms < b.ms; });
+    return ok;
+}
@@ -0,0 +1,360 @@
+// Claudius - firmware simulator (host build)
+//
+// Runs the unmodified DspTask and UiTask loops as std::threads on top of the
+// host HAL: virtual clock, scripted ADC/gate/encoder inputs, file- or
+// null-backed audio sink and an in-memory 128x64 display.
+//
+// Usage:
+//   program [--script FILE] [--seconds S] [--realtime] [-o out.wav]
+//           [--screenshot out.pbm] [--quiet]
+//
+// Prints "metric,value" CSV rows: DSP block render time and deadline
+// misses, the DSP task's own load meter, I2S underruns, voice arena peak, per-note cost, polyphony limit
+// and peak voice cycles per block (voice-change crossfades included),
+// gate edge timing (edges land on their sample one block late; age is how
+// long they waited, jitter how evenly blocks start), UI loop timing, and
+// knob to DSP latency.
+// In the default virtual-time mode, task work takes no simulated time, so
+// latencies reflect the task structure rather than this host's speed;
+// --realtime ties the clock to the wall clock to expose underruns.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Config.h"
+#include "Parameters.h"
+#include "dsp/DspTask.h"
+#include "hal/Adc.h"
+#include "hal/Mailbox.h"
+#include "hal/TripleBuffer.h"
+#include "hal/host/HostDisplay.h"
+#include "hal/host/SimClock.h"
+#include "hal/host/SimInputs.h"
+#include "native/common/WavWriter.h"
+#include "native/sim/SimScript.h"
+#include "ui/UiTask.h"
+
+// Same globals main.cpp provides on the device
+TripleBuffer<ParamMessage> gParamBuffer;
+Mailbox<StatusMessage> gStatusQueue;
+Adc gAdc;
+
+namespace {
+
+DspTask dspTask;
+UiTask uiTask;
+
+struct SimOptions {
+    const char* scriptPath = nullptr;
+    const char* outPath = nullptr;
+    const char* screenshotPath = nullptr;
+    float seconds = -1.0f;
+    bool realtime = false;
+    bool quiet = false;
+};
+
+struct LatencyStats {
+    uint32_t count = 0;
+    double sumMs = 0.0;
+    double maxMs = 0.0;
+
+    void add(double ms) {
+        count++;
+        sumMs += ms;
+        if (ms > maxMs) maxMs = ms;
+    }
+
+    double avgMs() const {
+        return count ? sumMs / count : 0.0;
+    }
+};
+
+// Tracks scripted input changes until the DSP task receives them
+class LatencyProbe {
+public:
+    void onInput(const SimEvent& event, const ParamMessage& current, uint64_t frame) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (isAnalogInput(event.input)) {
+            Pending& p = knobs_[static_cast<uint8_t>(event.input)];
+            p.active = true;
+            p.firstSeen = false;
+            p.frame = frame;
+            p.start = event.input == SimInput::CV2 ? lastPitchCv_ : analogField(current, event.input);
+            p.target = event.value;
+        }
+    }
+
+    // Called on the DSP thread whenever it takes a ParamMessage
+    void onReceive(const ParamMessage& params, uint64_t frame, uint64_t queuedFrames) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int ch = 0; ch < SimInputs::NUM_CHANNELS; ++ch) {
+            // Pitch CV bypasses the parameters, see onPitchCv()
+            if (ch == SimInputs::CV2) continue;
+            updateKnob(knobs_[ch], analogField(params, static_cast<SimInput>(ch)), frame, queuedFrames);
+        }
+    }
+
+    // Called on the DSP thread when it reads pitch CV from the ADC stream
+    void onPitchCv(float cv2, uint64_t frame, uint64_t queuedFrames) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lastPitchCv_ = cv2;
+        updateKnob(knobs_[SimInputs::CV2], cv2, frame, queuedFrames);
+    }
+
+    void report() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        printLatency("knob_first", knobFirst_);
+        printLatency("knob_settle", knobSettle_);
+        printLatency("knob_to_output", knobToOutput_);
+    }
+
+private:
+    static constexpr float kSettleTolerance = 0.01f;
+
+    struct Pending {
+        bool active = false;
+        bool firstSeen = false;
+        uint64_t frame = 0;
+        float start = 0.0f;
+        float target = 0.0f;
+    };
+
+    void updateKnob(Pending& p, float value, uint64_t frame, uint64_t queuedFrames) {
+        if (!p.active) return;
+
+        float step = p.target - p.start;
+        if (fabsf(step) < kSettleTolerance) {
+            p.active = false;
+            return;
+        }
+        if (!p.firstSeen && (value - p.start) / step >= 0.1f) {
+            p.firstSeen = true;
+            knobFirst_.add(msSince(p.frame, frame));
+        }
+        if (fabsf(value - p.target) <= kSettleTolerance) {
+            double ms = msSince(p.frame, frame);
+            knobSettle_.add(ms);
+            knobToOutput_.add(ms + msForFrames(queuedFrames));
+            p.active = false;
+        }
+    }
+
+    static float analogField(const ParamMessage& params, SimInput input) {
+        switch (input) {
+            case SimInput::CV0: return params.cv0;
+            case SimInput::CV1: return params.cv1;
+            case SimInput::CV2: return params.cv2;
+            case SimInput::POT0: return params.pot0;
+            case SimInput::POT1: return params.pot1;
+            case SimInput::POT2: return params.pot2;
+            default: return 0.0f;
+        }
+    }
+
+    static double msForFrames(uint64_t frames) {
+        return 1000.0 * static_cast<double>(frames) / SAMPLE_RATE;
+    }
+
+    static double msSince(uint64_t from, uint64_t to) {
+        return to > from ? msForFrames(to - from) : 0.0;
+    }
+
+    static void printLatency(const char* name, const LatencyStats& stats) {
+        std::printf("%s_count,%u\n", name, stats.count);
+        std::printf("%s_avg_ms,%.3f\n", name, stats.avgMs());
+        std::printf("%s_max_ms,%.3f\n", name, stats.maxMs);
+    }
+
+    std::mutex mutex_;
+    Pending knobs_[SimInputs::NUM_CHANNELS];
+    float lastPitchCv_ = 0.5f;
+    LatencyStats knobFirst_;
+    LatencyStats knobSettle_;
+    LatencyStats knobToOutput_;
+};
+
+void printUsage(const char* program) {
+    std::fprintf(stderr,
+        "usage: %s [--script FILE] [--seconds S] [--realtime] [-o out.wav]\n"
+        "          [--screenshot out.pbm] [--quiet]\n", program);
+}
+
+bool parseArgs(int argc, char** argv, SimOptions& opts) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--script") == 0 && hasValue) {
+            opts.scriptPath = argv[++i];
+        } else if (std::strcmp(arg, "--seconds") == 0 && hasValue) {
+            opts.seconds = std::strtof(argv[++i], nullptr);
+        } else if (std::strcmp(arg, "--realtime") == 0) {
+            opts.realtime = true;
+        } else if (std::strcmp(arg, "-o") == 0 && hasValue) {
+            opts.outPath = argv[++i];
+        } else if (std::strcmp(arg, "--screenshot") == 0 && hasValue) {
+            opts.screenshotPath = argv[++i];
+        } else if (std::strcmp(arg, "--quiet") == 0) {
+            opts.quiet = true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    SimOptions opts;
+    if (!parseArgs(argc, argv, opts)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    std::vector<SimEvent> events;
+    if (opts.scriptPath && !loadSimScript(opts.scriptPath, events)) {
+        return 2;
+    }
+    uint32_t endMs = (opts.seconds > 0.0f)
+        ? static_cast<uint32_t>(opts.seconds * 1000.0f)
+        : (events.empty() ? 2000 : events.back().ms + 1000);
+
+    platform::logEnabled() = !opts.quiet;
+
+    WavWriter wav;
+    if (opts.outPath) {
+        if (!wav.open(opts.outPath, static_cast<uint32_t>(SAMPLE_RATE))) {
+            std::fprintf(stderr, "cannot open %s for writing\n", opts.outPath);
+            return 2;
+        }
+        hostAudio().sink = [&wav](const float* samples, int count) { wav.write(samples, count); };
+    }
+
+    SimClock& clock = simClock();
+    clock.configure(opts.realtime ? SimClock::Mode::REALTIME : SimClock::Mode::VIRTUAL);
+
+    gStatusQueue.create();
+
+    LatencyProbe probe;
+    ParamMessage lastSent = makeDefaultParams();
+    std::mutex lastSentMutex;
+    gParamBuffer.setReadObserver([&](const ParamMessage& params) {
+        {
+            std::lock_guard<std::mutex> lock(lastSentMutex);
+            lastSent = params;
+        }
+        probe.onReceive(params, simClock().nowFrames(), hostAudio().queuedFrames);
+    });
+    gAdc.setPitchCvObserver([&probe](uint16_t raw) {
+        probe.onPitchCv(normalizeAdc(raw, CAL_CV2), simClock().nowFrames(), hostAudio().queuedFrames);
+    });
+
+    // Main (script driver), DSP and UI all sleep on the clock
+    TaskStats uiStats;
+    clock.addParticipant();
+    clock.addParticipant();
+    clock.addParticipant();
+
+    auto wallStart = SimClock::WallClock::now();
+    std::thread dspThread([] {
+        dspTask.init();
+        dspTask.run();
+        simClock().removeParticipant();
+    });
+    std::thread uiThread([&uiStats] {
+        SimClock::bindTaskStats(&uiStats);
+        uiTask.init();
+        uiTask.run();
+        SimClock::bindTaskStats(nullptr);
+        simClock().removeParticipant();
+    });
+
+    for (const SimEvent& event : events) {
+        if (event.ms > endMs) break;
+        if (!clock.waitUntil(clock.framesForMs(event.ms))) break;
+        ParamMessage current;
+        {
+            std::lock_guard<std::mutex> lock(lastSentMutex);
+            current = lastSent;
+        }
+        probe.onInput(event, current, clock.nowFrames());
+        applySimEvent(event, simInputs());
+    }
+    clock.waitUntil(clock.framesForMs(endMs));
+    double simSeconds = static_cast<double>(clock.nowFrames()) / SAMPLE_RATE;
+
+    clock.stop();
+    dspThread.join();
+    uiThread.join();
+    clock.removeParticipant();
+    double wallSeconds = std::chrono::duration<double>(SimClock::WallClock::now() - wallStart).count();
+    wav.close();
+
+    if (opts.screenshotPath && !hostDisplay().savePbm(opts.screenshotPath)) {
+        std::fprintf(stderr, "cannot write %s\n", opts.screenshotPath);
+    }
+
+    const HostAudioStats& audio = hostAudio();
+    const double blockBudgetUs = 1.0e6 * AUDIO_BLOCK_SIZE / SAMPLE_RATE;
+    const uint64_t blocks = audio.blocks;
+
+    std::printf("metric,value\n");
+    std::printf("mode,%s\n", opts.realtime ? "realtime" : "virtual");
+    std::printf("sim_seconds,%.3f\n", simSeconds);
+    std::printf("wall_seconds,%.3f\n", wallSeconds);
+    std::printf("dsp_blocks,%llu\n", static_cast<unsigned long long>(blocks));
+    std::printf("dsp_block_budget_us,%.1f\n", blockBudgetUs);
+    std::printf("dsp_block_avg_us,%.2f\n", blocks ? audio.renderNs / 1000.0 / blocks : 0.0);
+    std::printf("dsp_block_max_us,%.2f\n", audio.maxRenderNs / 1000.0);
+    std::printf("dsp_deadline_misses,%llu\n", static_cast<unsigned long long>(audio.deadlineMisses));
+    std::printf("i2s_underruns,%u\n", audio.underruns.load());
+    const DspLoadWindow& load = dspTask.getLoad();
+    std::printf("dsp_load_avg_pct,%.2f\n", load.avgPercent(dspTask.getCyclesPerBlock()));
+    std::printf("dsp_load_peak_pct,%.2f\n", load.peakPercent(dspTask.getCyclesPerBlock()));
+    std::printf("dsp_load_late_blocks,%u\n", dspTask.getDeadlineMisses());
+    std::printf("i2s_min_queued_frames,%lld\n", static_cast<long long>(audio.minQueuedFrames));
+    std::printf("voice_arena_peak_bytes,%zu\n", dspTask.getEngine().getArena().getPeak());
+    std::printf("voice_arena_capacity_bytes,%zu\n", dspTask.getEngine().getArena().getCapacity());
+    std::printf("poly_voice_cycles,%.0f\n", dspTask.getEngine().getVoiceCycles());
+    std::printf("poly_limit,%d\n", dspTask.getEngine().getPolyphonyLimit());
+    std::printf("poly_block_peak_cycles,%llu\n",
+                static_cast<unsigned long long>(dspTask.getEngine().getPeakBlockCycles()));
+    const GateEventStats& gate = dspTask.getGateStats();
+    std::printf("gate_edges,%u\n", gate.count);
+    std::printf("gate_edges_late,%u\n", gate.late);
+    std::printf("gate_edges_dropped,%u\n", dspTask.getDroppedGateEdges());
+    std::printf("gate_edges_resynced,%u\n", gate.resynced);
+    std::printf("gate_edge_age_avg_us,%.1f\n", gate.avgAgeUs());
+    std::printf("gate_edge_age_max_us,%u\n", gate.maxAgeUs);
+    std::printf("dsp_block_jitter_max_us,%u\n", gate.maxJitterUs);
+    std::printf("adc_samples_dropped,%u\n", gAdc.getDropped());
+    std::printf("adc_wakeups_per_sec,%.1f\n", simSeconds > 0.0 ? gAdc.getWakeups() / simSeconds : 0.0);
+    std::printf("ui_loops,%llu\n", static_cast<unsigned long long>(uiStats.iterations));
+    std::printf("ui_loops_per_sec,%.1f\n", simSeconds > 0.0 ? uiStats.iterations / simSeconds : 0.0);
+    std::printf("ui_loop_avg_us,%.2f\n", uiStats.avgBusyUs());
+    std::printf("ui_loop_max_us,%.2f\n", uiStats.maxBusyNs / 1000.0);
+    const UiTask::Scheduler& scheduler = uiTask.getScheduler();
+    for (int i = 0; i < scheduler.getJobCount(); ++i) {
+        const UiJobStats& job = scheduler.getJobStats(i);
+        const char* name = scheduler.getJobName(i);
+        std::printf("ui_job_%s_runs,%u\n", name, job.runs);
+        std::printf("ui_job_%s_avg_us,%.2f\n", name, job.avgUs());
+        std::printf("ui_job_%s_max_us,%.2f\n", name, job.maxUs());
+    }
+    std::printf("display_frames,%llu\n", static_cast<unsigned long long>(hostDisplay().frames));
+    std::printf("display_bytes,%llu\n", static_cast<unsigned long long>(hostDisplay().bytesSent));
+    uint64_t displayFrames = hostDisplay().frames;
+    std::printf("display_bytes_per_frame,%.1f\n",
+                displayFrames > 0 ? static_cast<double>(hostDisplay().bytesSent) / displayFrames : 0.0);
+    std::printf("display_peak_frame_bytes,%u\n", hostDisplay().peakFrameBytes.load());
+    std::printf("display_peak_chunk_bytes,%u\n", hostDisplay().peakChunkBytes.load());
+    std::printf("display_peak_chunk_bus_us,%u\n", PageDiff::busMicros(hostDisplay().peakChunkBytes.load()));
+    probe.report();
+    return 0;
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstdint>
+#include "../hal/CycleCounter.h"
+#include "../hal/Platform.h"
+
+// Execution time of a scheduler job, or of whole scheduler passes
+struct UiJobStats {
+    uint32_t runs = 0;
+    uint64_t sumCycles = 0;
+    uint64_t maxCycles = 0;
+
+    void add(uint64_t cycles) {
+        runs++;
+        sumCycles += cycles;
+        if (cycles > maxCycles) maxCycles = cycles;
+    }
+
+    float avgUs() const {
+        return runs ? toUs(sumCycles) / static_cast<float>(runs) : 0.0f;
+    }
+
+    float maxUs() const {
+        return toUs(maxCycles);
+    }
+
+    static float toUs(uint64_t cycles) {
+        return static_cast<float>(cycles) * 1.0e6f / static_cast<float>(platform::cycleRate());
+    }
+};
+
+// Deadline scheduler for the UI task.
+//
+// A job is a member function of the owner that returns the milliseconds
+// until it wants to run again, or kIdle to wait for wake(). A pass runs the
+// jobs that are due, in the order they were added; then the task sleeps
+// until the earliest deadline or a task notification (encoder interrupt),
+// which wakes the jobs added with onNotify. Between deadlines core 0 is left
+// to the idle task.
+
+template<typename Owner, int MaxJobs>
+class UiScheduler {
+public:
+    using Job = uint32_t (Owner::*)();
+
+    static constexpr uint32_t kIdle = UINT32_MAX;
+    static constexpr uint32_t kMaxSleepMs = 1000;
+
+    explicit UiScheduler(Owner& owner)
+        : owner_(owner)
+        , count_(0)
+        , wakeups_(0)
+        , busyCycles_(0)
+    {
+    }
+
+    // Returns the job's id. Jobs first run firstDelayMs after being added.
+    int add(const char* name, Job job, bool onNotify = false, uint32_t firstDelayMs = 0) {
+        if (count_ >= MaxJobs) return -1;
+        Entry& entry = jobs_[count_];
+        entry.name = name;
+        entry.job = job;
+        entry.onNotify = onNotify;
+        entry.idle = false;
+        entry.dueMs = platform::millis() + firstDelayMs;
+        return count_++;
+    }
+
+    // Make a job due now; from the UI task only
+    void wake(int id) {
+        jobs_[id].idle = false;
+        jobs_[id].dueMs = platform::millis();
+    }
+
+    void run() {
+        while (platform::keepRunning()) {
+            platform::CycleCount start = platform::cycleCount();
+            runDue();
+            uint32_t sleepMs = msUntilNextDeadline();
+            platform::CycleCount cycles = platform::cycleCount() - start;
+            passes_.add(cycles);
+            busyCycles_ += cycles;
+
+            if (platform::waitNotify(sleepMs)) {
+                for (int i = 0; i < count_; ++i) {
+                    if (jobs_[i].onNotify) wake(i);
+                }
+            }
+            wakeups_++;
+        }
+    }
+
+    int getJobCount() const {
+        return count_;
+    }
+
+    const char* getJobName(int id) const {
+        return jobs_[id].name;
+    }
+
+    const UiJobStats& getJobStats(int id) const {
+        return jobs_[id].stats;
+    }
+
+    // Whole passes: jobs plus the scheduler's own work
+    const UiJobStats& getPassStats() const {
+        return passes_;
+    }
+
+    uint32_t getWakeups() const {
+        return wakeups_;
+    }
+
+    uint64_t getBusyCycles() const {
+        return busyCycles_;
+    }
+
+private:
+    struct Entry {
+        const char* name;
+        Job job;
+        bool onNotify;
+        bool idle;
+        uint32_t dueMs;
+        UiJobStats stats;
+    };
+
+    static bool isDue(uint32_t dueMs, uint32_t now) {
+        return static_cast<int32_t>(dueMs - now) <= 0;
+    }
+
+    void runDue() {
+        for (int i = 0; i < count_; ++i) {
+            Entry& entry = jobs_[i];
+            if (entry.idle || !isDue(entry.dueMs, platform::millis())) continue;
+
+            platform::CycleCount start = platform::cycleCount();
+            uint32_t delayMs = (owner_.*entry.job)();
+            entry.stats.add(platform::cycleCount() - start);
+
+            if (delayMs == kIdle) {
+                entry.idle = true;
+            } else {
+                // At least a tick, so a busy job cannot starve the idle task
+                entry.dueMs = platform::millis() + (delayMs > 0 ? delayMs : 1);
+            }
+        }
+    }
+
+    uint32_t msUntilNextDeadline() const {
+        uint32_t now = platform::millis();
+        uint32_t sleepMs = kMaxSleepMs;
+        for (int i = 0; i < count_; ++i) {
+            const Entry& entry = jobs_[i];
+            if (entry.idle) continue;
+            if (isDue(entry.dueMs, now)) return 0;
+            uint32_t untilDue = entry.dueMs - now;
+            if (untilDue < sleepMs) sleepMs = untilDue;
+        }
+        return sleepMs;
+    }
+
+    Owner& owner_;
+    Entry jobs_[MaxJobs];
+    int count_;
+    UiJobStats passes_;
+    uint32_t wakeups_;
+    uint64_t busyCycles_;
+};
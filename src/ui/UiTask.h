@@ -1,145 +1,252 @@
 #pragma once
 
-#include <Arduino.h>
-#include <freertos/FreeRTOS.h>
-#include <freertos/queue.h>
+#include <cstdio>
+#include <cstring>
 #include "Parameters.h"
+#include "ParamTable.h"
 #include "Config.h"
 #include "Calibration.h"
 #include "Utils.h"
+#include "../dsp/Voices.h"
 #include "../hal/Adc.h"
 #include "../hal/Encoder.h"
 #include "../hal/Display.h"
-#include "../hal/Gate.h"
+#include "../hal/Mailbox.h"
+#include "../hal/TripleBuffer.h"
+#include "../hal/Platform.h"
+#include "UiScheduler.h"
 
-extern QueueHandle_t gParamQueue;
-extern QueueHandle_t gStatusQueue;
+extern TripleBuffer<ParamMessage> gParamBuffer;
+extern Adc gAdc;
+extern Mailbox<StatusMessage> gStatusQueue;
+
+// UI core: menus, knob and CV intake, display. The work is split into
+// jobs run by a deadline scheduler (UiScheduler); between them the task
+// sleeps until the next deadline or an encoder interrupt.
 
 class UiTask {
 public:
+    static constexpr int kJobCount = 6;
+    using Scheduler = UiScheduler<UiTask, kJobCount>;
+
+    UiTask()
+        : scheduler_(*this)
+        , transferJob_(-1)
+        , menuDirty_(kAllParams)
+        , status_{}
+        , lastLogCycles_(0)
+        , lastLogWakeups_(0)
+        , lastLogAdcWakeups_(0)
+        , lastLogMs_(0)
+    {
+        // Silent and idle at A3 until the DSP core reports
+        status_.currentFreq = 220.0f;
+    }
+
     void init() {
-        adc_.init();
+        gAdc.init();
         encoder_.init();
         if (!display_.init()) {
-            Serial.println("Display init failed!");
+            platform::log("Display init failed!\n");
         }
-        gate_.init();
 
         // Initialize parameter values
-        params_.attack = 0.1f;
-        params_.decay = 0.5f;
-        params_.wavefold = 0.0f;
-        params_.chaos = 0.0f;
-        params_.fmFeedback = 0.2f;
-        params_.fmFold = 0.0f;
-        params_.verbMix = 0.6f;
-        params_.verbExcite = 0.5f;
-        params_.voice = static_cast<uint8_t>(VoiceType::CASCADE);
-        params_.cvPitchOffset = 0.0f;
-        params_.cvPitchScale = 1.0f;
+        params_ = makeDefaultParams();
 
         currentPage_ = MenuPage::VOICE;
         selectedItem_ = 0;
+
+        // The panel starts blank
+        for (char* line : shownLines_) {
+            line[0] = '\0';
+        }
+        shownSelected_ = -1;
+        shownPage_ = MenuPage::NUM_PAGES;
+        shownVoice_ = -1;
+        shownPlaying_ = -1;
+        shownBarWidth_ = -1;
+        shownFreq_ = -1;
     }
 
     void run() {
-        unsigned long lastAdcRead = 0;
-        unsigned long lastDisplayUpdate = 0;
+        // Drawing and the display transfer are split so that no pass blocks
+        // for more than one bus chunk
+        scheduler_.add("input", &UiTask::inputJob, true);
+        scheduler_.add("adc", &UiTask::adcJob);
+        scheduler_.add("status", &UiTask::statusJob);
+        scheduler_.add("draw", &UiTask::drawJob);
+        transferJob_ = scheduler_.add("transfer", &UiTask::transferJob);
+        scheduler_.add("log", &UiTask::logJob, false, kLogIntervalMs);
+        lastLogMs_ = platform::millis();
+        scheduler_.run();
+    }
 
-        // Smoothed ADC values
-        float smoothCv0 = 0.5f, smoothCv1 = 0.5f, smoothCv2 = 0.5f;
-        float smoothPot0 = 0.5f, smoothPot1 = 0.5f, smoothPot2 = 0.5f;
+    const Scheduler& getScheduler() const {
+        return scheduler_;
+    }
 
-        StatusMessage status = {0.0f, false, 220.0f};
+private:
+    enum class MenuPage : uint8_t {
+        VOICE = 0,
+        SHAPE,
+        ENV,
+        CURVE,
+        PITCH,
+        DSP,  // Load meter, read only
+        NUM_PAGES
+    };
 
-        while (true) {
-            unsigned long now = millis();
+    static constexpr uint32_t kStatusPollMs = DISPLAY_UPDATE_MS / 2;  // DSP sends every 100 ms
+    static constexpr uint32_t kLogIntervalMs = 1000;
 
-            // Read encoder
-            if (encoder_.readButtonPress()) {
-                handleButtonPress();
-            }
+    // Woken by the encoder interrupts; menu edits go to the DSP at once
+    uint32_t inputJob() {
+        if (encoder_.readButtonPress()) {
+            handleButtonPress();
+        }
 
-            int8_t rotation = encoder_.readRotation();
-            if (rotation != 0) {
-                handleRotation(rotation);
-            }
+        EncoderMotion motion = encoder_.readMotion();
+        if (motion.detents != 0) {
+            handleRotation(motion);
+        }
+        publishParams();
+        return Scheduler::kIdle;
+    }
 
-            // Read ADCs at interval
-            if (now - lastAdcRead >= ADC_READ_INTERVAL_MS) {
-                // Read and normalize CVs
-                float cv0 = normalizeAdc(adc_.readCv0(), CAL_CV0);
-                float cv1 = normalizeAdc(adc_.readCv1(), CAL_CV1);
-                float cv2 = normalizeAdc(adc_.readCv2(), CAL_CV2);
-
-                // Read and normalize pots
-                float pot0 = normalizeAdc(adc_.readPot0(), CAL_POT0);
-                float pot1 = normalizeAdc(adc_.readPot1(), CAL_POT1);
-                float pot2 = normalizeAdc(adc_.readPot2(), CAL_POT2);
-
-                // Smooth values
-                constexpr float alpha = 0.2f;
-                smoothCv0 = smoothCv0 * (1.0f - alpha) + cv0 * alpha;
-                smoothCv1 = smoothCv1 * (1.0f - alpha) + cv1 * alpha;
-                smoothCv2 = smoothCv2 * (1.0f - alpha) + cv2 * alpha;
-                smoothPot0 = smoothPot0 * (1.0f - alpha) + pot0 * alpha;
-                smoothPot1 = smoothPot1 * (1.0f - alpha) + pot1 * alpha;
-                smoothPot2 = smoothPot2 * (1.0f - alpha) + pot2 * alpha;
-
-                // Update params
-                params_.cv0 = smoothCv0;
-                params_.cv1 = smoothCv1;
-                params_.cv2 = smoothCv2;
-                params_.pot0 = smoothPot0;
-                params_.pot1 = smoothPot1;
-                params_.pot2 = smoothPot2;
-
-                // Read gate
-                params_.gateIn = gate_.readGateIn();
-
-                // Send to DSP
-                xQueueOverwrite(gParamQueue, &params_);
-
-                lastAdcRead = now;
-            }
+    uint32_t adcJob() {
+        // Newest decimated readings; the sampler's filter does the
+        // smoothing. Pitch CV goes to the DSP task directly.
+        setParam(params_, ParamId::CV0, normalizeAdc(gAdc.readCv0(), CAL_CV0));
+        setParam(params_, ParamId::CV1, normalizeAdc(gAdc.readCv1(), CAL_CV1));
+        setParam(params_, ParamId::POT0, normalizeAdc(gAdc.readPot0(), CAL_POT0));
+        setParam(params_, ParamId::POT1, normalizeAdc(gAdc.readPot1(), CAL_POT1));
+        setParam(params_, ParamId::POT2, normalizeAdc(gAdc.readPot2(), CAL_POT2));
+        publishParams();
+        return ADC_READ_INTERVAL_MS;
+    }
 
-            // Read status from DSP
-            xQueueReceive(gStatusQueue, &status, 0);
+    uint32_t statusJob() {
+        gStatusQueue.receive(status_);
+        return kStatusPollMs;
+    }
 
-            // Update display at interval
-            if (now - lastDisplayUpdate >= DISPLAY_UPDATE_MS) {
-                display_.clear();
+    // Draw a new frame once the last one is out
+    uint32_t drawJob() {
+        if (!display_.isIdle()) return 1;
+        drawMenu();
+        drawStatus(status_);
+        display_.update();
+        scheduler_.wake(transferJob_);
+        return DISPLAY_UPDATE_MS;
+    }
 
-                char line[32];
-                formatTitleLine(line, sizeof(line));
-                display_.showMenuLine(line, 0, selectedItem_ == 0);
+    // One bus chunk per tick until the frame is out
+    uint32_t transferJob() {
+        display_.sendNext();
+        return display_.isIdle() ? Scheduler::kIdle : 1;
+    }
 
-                int itemCount = getPageItemCount(currentPage_);
-                for (int i = 0; i < itemCount; ++i) {
-                    formatMenuItem(currentPage_, i, line, sizeof(line));
-                    display_.showMenuLine(line, i + 1, selectedItem_ == (i + 1));
-                }
+    uint32_t logJob() {
+        uint32_t now = platform::millis();
+        uint64_t busyCycles = scheduler_.getBusyCycles();
+        uint32_t wakeups = scheduler_.getWakeups();
+        uint32_t adcWakeups = gAdc.getWakeups();
+        float seconds = static_cast<float>(now - lastLogMs_) / 1000.0f;
+        if (seconds > 0.0f) {
+            float busyShare = UiJobStats::toUs(busyCycles - lastLogCycles_) / (seconds * 1.0e6f);
+            const UiJobStats& passes = scheduler_.getPassStats();
+            // The ADC sampler task shares the core, so its wakeups count too
+            platform::log("UI idle:%.1f%% wakeups:%.0f/s + adc %.0f/s | pass avg:%.0f max:%.0f us\n",
+                100.0f * (1.0f - busyShare), static_cast<float>(wakeups - lastLogWakeups_) / seconds,
+                static_cast<float>(adcWakeups - lastLogAdcWakeups_) / seconds, passes.avgUs(), passes.maxUs());
+        }
+        for (int i = 0; i < scheduler_.getJobCount(); ++i) {
+            const UiJobStats& job = scheduler_.getJobStats(i);
+            platform::log("UI job %s runs:%u avg:%.0f max:%.0f us\n",
+                scheduler_.getJobName(i), static_cast<unsigned>(job.runs), job.avgUs(), job.maxUs());
+        }
+        const DisplayStats& stats = display_.getStats();
+        platform::log("OLED frames:%u bytes/frame avg:%.0f last:%u peak:%u | chunk peak:%u B %u us\n",
+            static_cast<unsigned>(stats.frames), stats.avgFrameBytes(),
+            static_cast<unsigned>(stats.lastFrameBytes), static_cast<unsigned>(stats.peakFrameBytes),
+            static_cast<unsigned>(stats.peakChunkBytes),
+            static_cast<unsigned>(PageDiff::busMicros(stats.peakChunkBytes)));
+        lastLogCycles_ = busyCycles;
+        lastLogWakeups_ = wakeups;
+        lastLogAdcWakeups_ = adcWakeups;
+        lastLogMs_ = now;
+        return kLogIntervalMs;
+    }
 
-                // Show status
-                display_.showStatus(status.currentFreq, status.outputLevel, status.isPlaying);
+    // Send to DSP when something changed. The snapshot carries the bits of
+    // what changed since the last one; the menu keeps them until it draws.
+    void publishParams() {
+        if (params_.dirty == 0) return;
+        menuDirty_ |= params_.dirty;
+        gParamBuffer.publish(params_);
+        params_.dirty = 0;
+    }
 
-                display_.update();
-                lastDisplayUpdate = now;
-            }
+    static constexpr int kMenuRows = 5;    // Title and up to four items
+    static constexpr int kLineLength = 32;
 
-            // Small delay to prevent tight loop
-            vTaskDelay(1);
+    // Redraw the menu lines whose text or highlight changed. Lines are
+    // only reformatted when the page or voice changed or their parameter
+    // did; the DSP page follows every status message.
+    void drawMenu() {
+        int voice = selectedVoiceIndex();
+        bool layoutChanged = currentPage_ != shownPage_ || voice != shownVoice_;
+        bool diagnostics = currentPage_ == MenuPage::DSP;
+        int itemCount = getPageItemCount(currentPage_);
+        for (int row = 0; row < kMenuRows; ++row) {
+            bool hasItem = row > 0 && row <= itemCount;
+            bool reformat = layoutChanged || (diagnostics && row > 0)
+                || (hasItem && (menuDirty_ & paramBit(pageItem(currentPage_, row - 1))));
+            char line[kLineLength] = "";
+            if (!reformat) {
+                std::memcpy(line, shownLines_[row], sizeof(line));
+            } else if (row == 0) {
+                formatTitleLine(line, sizeof(line));
+            } else if (diagnostics) {
+                formatLoadLine(row - 1, line, sizeof(line));
+            } else if (hasItem) {
+                formatMenuItem(pageItem(currentPage_, row - 1), line, sizeof(line));
+            }
+            bool selected = selectedItem_ == row;
+            if (std::strcmp(line, shownLines_[row]) == 0 && selected == (shownSelected_ == row)) {
+                continue;
+            }
+            if (line[0] == '\0' && !selected) {
+                display_.clearMenuLine(row);
+            } else {
+                display_.showMenuLine(line, row, selected);
+            }
+            std::memcpy(shownLines_[row], line, sizeof(line));
         }
+        shownSelected_ = selectedItem_;
+        shownPage_ = currentPage_;
+        shownVoice_ = voice;
+        menuDirty_ = 0;
     }
 
-private:
-    enum class MenuPage : uint8_t {
-        VOICE = 0,
-        SHAPE,
-        ENV,
-        PITCH,
-        NUM_PAGES
-    };
+    // Redraw the status fields whose shown value changed
+    void drawStatus(const StatusMessage& status) {
+        int playing = status.isPlaying ? 1 : 0;
+        if (playing != shownPlaying_) {
+            display_.showPlaying(status.isPlaying);
+            shownPlaying_ = playing;
+        }
+        int barWidth = Display::levelBarWidth(status.outputLevel);
+        if (barWidth != shownBarWidth_) {
+            display_.showLevel(barWidth);
+            shownBarWidth_ = barWidth;
+        }
+        int freq = static_cast<int>(status.currentFreq + 0.5f);
+        if (freq != shownFreq_) {
+            display_.showFrequency(freq);
+            shownFreq_ = freq;
+        }
+    }
 
     void handleButtonPress() {
         int itemCount = getPageItemCount(currentPage_);
@@ -149,170 +256,152 @@ private:
         }
     }
 
-    void handleRotation(int8_t delta) {
+    // Lists move one entry per detent; levels move by the accelerated
+    // count, so a fast turn sweeps the range
+    void handleRotation(const EncoderMotion& motion) {
         if (selectedItem_ == 0) {
             int pageCount = static_cast<int>(MenuPage::NUM_PAGES);
-            int next = static_cast<int>(currentPage_) + (delta > 0 ? 1 : -1);
-            if (next < 0) next = pageCount - 1;
-            if (next >= pageCount) next = 0;
-            currentPage_ = static_cast<MenuPage>(next);
+            currentPage_ = static_cast<MenuPage>(wrapIndex(static_cast<int>(currentPage_) + motion.detents, pageCount));
             return;
         }
 
-        adjustMenuItem(currentPage_, selectedItem_ - 1, delta);
+        adjustMenuItem(pageItem(currentPage_, selectedItem_ - 1), motion);
+    }
+
+    static int wrapIndex(int index, int count) {
+        index %= count;
+        return index < 0 ? index + count : index;
+    }
+
+    static constexpr ParamId kVoiceItems[] = {ParamId::VOICE};
+    static constexpr ParamId kEnvItems[] = {ParamId::ATTACK, ParamId::DECAY, ParamId::SUSTAIN, ParamId::RELEASE};
+    static constexpr ParamId kCurveItems[] = {ParamId::ENV_CURVE};
+    static constexpr ParamId kPitchItems[] = {ParamId::CV_PITCH_OFFSET, ParamId::CV_PITCH_SCALE};
+
+    template<int N>
+    static constexpr int countOf(const ParamId (&)[N]) {
+        return N;
     }
 
     int getPageItemCount(MenuPage page) const {
         switch (page) {
-            case MenuPage::VOICE: return 1;
-            case MenuPage::SHAPE: return 2;
-            case MenuPage::ENV: return 2;
-            case MenuPage::PITCH: return 2;
-            default: return 0;
+            case MenuPage::VOICE: return countOf(kVoiceItems);
+            case MenuPage::SHAPE: return selectedVoiceInfo().shapeItemCount;
+            case MenuPage::ENV: return countOf(kEnvItems);
+            case MenuPage::CURVE: return countOf(kCurveItems);
+            case MenuPage::PITCH: return countOf(kPitchItems);
+            default: return 0;  // DSP: nothing to edit
         }
     }
 
-    void adjustMenuItem(MenuPage page, int itemIndex, int8_t delta) {
-        constexpr float kStep = 0.04f;
-        float step = kStep * static_cast<float>(delta);
-        VoiceType voice = static_cast<VoiceType>(params_.voice);
-
+    // Parameter behind an item; index < getPageItemCount(page)
+    ParamId pageItem(MenuPage page, int itemIndex) const {
         switch (page) {
-            case MenuPage::VOICE:
-                if (itemIndex == 0) {
-                    int voices = static_cast<int>(VoiceType::NUM_VOICES);
-                    int next = static_cast<int>(params_.voice) + (delta > 0 ? 1 : -1);
-                    if (next < 0) next = voices - 1;
-                    if (next >= voices) next = 0;
-                    params_.voice = static_cast<uint8_t>(next);
-                }
-                break;
-            case MenuPage::SHAPE:
-                if (voice == VoiceType::CASCADE) {
-                    if (itemIndex == 0) {
-                        params_.wavefold = clamp(params_.wavefold + step, 0.0f, 1.0f);
-                    } else if (itemIndex == 1) {
-                        params_.chaos = clamp(params_.chaos + step, 0.0f, 1.0f);
-                    }
-                } else if (voice == VoiceType::ORBIT_FM) {
-                    if (itemIndex == 0) {
-                        params_.fmFeedback = clamp(params_.fmFeedback + step, 0.0f, 1.0f);
-                    } else if (itemIndex == 1) {
-                        params_.fmFold = clamp(params_.fmFold + step, 0.0f, 1.0f);
-                    }
-                } else {
-                    if (itemIndex == 0) {
-                        params_.verbMix = clamp(params_.verbMix + step, 0.0f, 1.0f);
-                    } else if (itemIndex == 1) {
-                        params_.verbExcite = clamp(params_.verbExcite + step, 0.0f, 1.0f);
-                    }
-                }
-                break;
-            case MenuPage::ENV:
-                if (itemIndex == 0) {
-                    params_.attack = clamp(params_.attack + step, 0.0f, 1.0f);
-                } else if (itemIndex == 1) {
-                    params_.decay = clamp(params_.decay + step, 0.0f, 1.0f);
-                }
-                break;
-            case MenuPage::PITCH:
-                if (itemIndex == 0) {
-                    params_.cvPitchOffset = clamp(params_.cvPitchOffset + step, -1.0f, 1.0f);
-                } else if (itemIndex == 1) {
-                    params_.cvPitchScale = clamp(params_.cvPitchScale + step, 0.0f, 2.0f);
-                }
-                break;
-            default:
-                break;
+            case MenuPage::SHAPE: return selectedVoiceInfo().shapeItems[itemIndex];
+            case MenuPage::ENV: return kEnvItems[itemIndex];
+            case MenuPage::CURVE: return kCurveItems[itemIndex];
+            case MenuPage::PITCH: return kPitchItems[itemIndex];
+            default: return kVoiceItems[0];
         }
     }
 
+    void adjustMenuItem(ParamId id, const EncoderMotion& motion) {
+        if (id == ParamId::VOICE) {
+            // Step through the voices that are built in
+            int next = wrapIndex(selectedVoiceIndex() + motion.detents, ClaudiusVoices::kCount);
+            setParam(params_, id, static_cast<float>(static_cast<int>(ClaudiusVoices::info(next).type)));
+            return;
+        }
+        adjustParam(params_, id, motion.detents, motion.accelerated);
+    }
+
     void formatTitleLine(char* out, size_t size) const {
         const char* title = "MENU";
         switch (currentPage_) {
             case MenuPage::VOICE: title = "VOICE"; break;
             case MenuPage::SHAPE: title = "SHAPE"; break;
             case MenuPage::ENV: title = "ENV"; break;
+            case MenuPage::CURVE: title = "ENV CURVE"; break;
             case MenuPage::PITCH: title = "PITCH CV"; break;
+            case MenuPage::DSP: title = "DSP LOAD"; break;
             default: break;
         }
         snprintf(out, size, "%s < >", title);
     }
 
-    void formatMenuItem(MenuPage page, int itemIndex, char* out, size_t size) const {
-        VoiceType voice = static_cast<VoiceType>(params_.voice);
-        switch (page) {
-            case MenuPage::VOICE:
-                if (itemIndex == 0) {
-                    const char* voiceName = (voice == VoiceType::CASCADE)
-                        ? "Cascade"
-                        : (voice == VoiceType::ORBIT_FM ? "Orbit FM" : "PitchVerb");
-                    snprintf(out, size, "Voice: %s", voiceName);
-                }
+    void formatMenuItem(ParamId id, char* out, size_t size) const {
+        if (id == ParamId::VOICE) {
+            snprintf(out, size, "Voice: %s", selectedVoiceInfo().name);
+            return;
+        }
+        formatParam(params_, id, out, size);
+    }
+
+    // DSP page: block load, the selected voice's cost per note and the
+    // polyphony it allows, missed deadlines and underruns, then every
+    // voice's cost by initial
+    void formatLoadLine(int line, char* out, size_t size) const {
+        switch (line) {
+            case 0:
+                snprintf(out, size, "Load:%.0f%% pk:%.0f%%", status_.loadAvg, status_.loadPeak);
                 break;
-            case MenuPage::SHAPE:
-                if (voice == VoiceType::CASCADE) {
-                    if (itemIndex == 0) {
-                        formatPercentLine("Wavefold", params_.wavefold, out, size);
-                    } else if (itemIndex == 1) {
-                        formatPercentLine("Chaos", params_.chaos, out, size);
-                    }
-                } else if (voice == VoiceType::ORBIT_FM) {
-                    if (itemIndex == 0) {
-                        formatPercentLine("Feedback", params_.fmFeedback, out, size);
-                    } else if (itemIndex == 1) {
-                        formatPercentLine("Fold", params_.fmFold, out, size);
-                    }
-                } else {
-                    if (itemIndex == 0) {
-                        formatPercentLine("Mix", params_.verbMix, out, size);
-                    } else if (itemIndex == 1) {
-                        formatPercentLine("Excite", params_.verbExcite, out, size);
-                    }
-                }
+            case 1: {
+                int type = static_cast<int>(selectedVoiceInfo().type);
+                snprintf(out, size, "Note:%.1f%% poly %u/%u", status_.voiceLoad[type],
+                    static_cast<unsigned>(status_.notes), static_cast<unsigned>(status_.polyLimit));
                 break;
-            case MenuPage::ENV:
-                if (itemIndex == 0) {
-                    formatTimeLine("Attack", params_.attack, 1.0f, 2000.0f, out, size);
-                } else if (itemIndex == 1) {
-                    formatTimeLine("Decay", params_.decay, 10.0f, 8000.0f, out, size);
-                }
+            }
+            case 2:
+                snprintf(out, size, "Late:%u Xrun:%u", static_cast<unsigned>(status_.deadlineMisses),
+                    static_cast<unsigned>(status_.underruns));
                 break;
-            case MenuPage::PITCH:
-                if (itemIndex == 0) {
-                    float offsetPercent = params_.cvPitchOffset * 100.0f;
-                    snprintf(out, size, "Offset: %+.0f%%", offsetPercent);
-                } else if (itemIndex == 1) {
-                    float scalePercent = params_.cvPitchScale * 100.0f;
-                    snprintf(out, size, "Scale: %.0f%%", scalePercent);
+            case 3: {
+                int length = 0;
+                for (int i = 0; i < ClaudiusVoices::kCount && length < static_cast<int>(size); ++i) {
+                    const VoiceInfo& info = ClaudiusVoices::info(i);
+                    length += snprintf(out + length, size - length, "%s%c%.1f", i > 0 ? " " : "",
+                        info.name[0], status_.voiceLoad[static_cast<int>(info.type)]);
                 }
                 break;
+            }
             default:
-                snprintf(out, size, "");
                 break;
         }
     }
 
-    void formatPercentLine(const char* name, float normalized, char* out, size_t size) const {
-        float value = linMap(normalized, 0.0f, 100.0f);
-        snprintf(out, size, "%s: %.0f%%", name, value);
+    // Registry index of the selected voice; IDs with no voice built in
+    // fall back to the first one
+    int selectedVoiceIndex() const {
+        int index = ClaudiusVoices::indexOf(static_cast<VoiceType>(params_.voice));
+        return index < 0 ? 0 : index;
     }
 
-    void formatTimeLine(const char* name, float normalized, float minMs, float maxMs, char* out, size_t size) const {
-        float value = expMap(normalized, minMs, maxMs);
-        if (value >= 1000.0f) {
-            snprintf(out, size, "%s: %.1fs", name, value / 1000.0f);
-        } else {
-            snprintf(out, size, "%s: %.0fms", name, value);
-        }
+    const VoiceInfo& selectedVoiceInfo() const {
+        return ClaudiusVoices::info(selectedVoiceIndex());
     }
 
-    Adc adc_;
+    Scheduler scheduler_;
+    int transferJob_;
     Encoder encoder_;
     Display display_;
-    Gate gate_;
 
     ParamMessage params_;
+    ParamMask menuDirty_;  // Changed since the menu was last drawn
     MenuPage currentPage_;
     int selectedItem_;
+    StatusMessage status_;
+
+    // What the panel shows, to skip unchanged lines and fields
+    char shownLines_[kMenuRows][kLineLength];
+    int shownSelected_;
+    MenuPage shownPage_;
+    int shownVoice_;
+    int shownPlaying_;
+    int shownBarWidth_;
+    int shownFreq_;
+
+    uint64_t lastLogCycles_;
+    uint32_t lastLogWakeups_;
+    uint32_t lastLogAdcWakeups_;
+    uint32_t lastLogMs_;
 };